@@ -3,12 +3,14 @@
 #define HAVE_WORKER_H
 
 #include <iostream>
+#include <vector>
 #include <ext/stdio_filebuf.h>
 #include <arpa/inet.h>
 
 #include "disambiguation_request.pb.h"
 
 #include "../graph/rgraph.h"
+#include "../config.h"
 
 
 
@@ -104,15 +106,19 @@ template <class R> mico::network::Connection<R>& mico::network::Connection<R>::o
 template <class R> mico::network::Connection<R>& mico::network::Connection<R>::operator>>(R &r) {
 
   if( !in->eof() ) {
-    // read length of next message
+    // read length of next message; the length is given by the peer, so it is checked before
+    // anything is allocated
     uint32_t length;
     in->read((char*)&length, sizeof(int));
+    size_t size = ntohl(length);
 
-    char buf[length];  
-    in->read(buf,ntohl(length));
+    if(*in && size <= MESSAGE_MAX_SIZE) {
+      std::vector<char> buf(size);
+      in->read(buf.data(), size);
 
-    if(*in) {
-      r.ParseFromArray(buf, ntohl(length));
+      if(*in) {
+	r.ParseFromArray(buf.data(), size);
+      }
     }
   }
   return *this;
@@ -125,18 +131,28 @@ template <class R> R* mico::network::Connection<R>::nextRequest() {
     return NULL;
   }
 
-  // read length of next message
+  // read length of next message; at the end of the stream, there is none
   uint32_t length;
   in->read((char*)&length, sizeof(int));
+  if(!*in) {
+    return NULL;
+  }
+
+  // the length is given by the peer: refuse messages larger than any request before allocating
+  size_t size = ntohl(length);
+  if(size > MESSAGE_MAX_SIZE) {
+    std::cerr << "refusing message of " << size << " bytes (at most " << MESSAGE_MAX_SIZE << " allowed)\n";
+    return NULL;
+  }
 
-  char buf[ntohl(length)];  
-  in->read(buf,ntohl(length));
+  std::vector<char> buf(size);
+  in->read(buf.data(), size);
 
-  std::cout << "reading in next message of " << ntohl(length) << " bytes\n";
+  std::cout << "reading in next message of " << size << " bytes\n";
 
   if(*in) {
     R* r = new R(); 
-    if(r->ParseFromArray(buf, ntohl(length))) {
+    if(r->ParseFromArray(buf.data(), size)) {
       return r;
     } else {
       delete r;
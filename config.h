@@ -33,6 +33,193 @@
 #define RESERVE_EDGES 1<<24
 
 
+/**
+ * Size (log2 of the number of bits) of the bitmap sketches used for approximating multi-hop
+ * neighborhoods in the NEIGHBORHOOD relatedness algorithms; larger values give more precise
+ * overlap estimates for big neighborhoods but cost more memory and time per comparison
+ */
+#define NEIGHBORHOOD_BITS_LOG 12
+#define NEIGHBORHOOD_BITS     (1<<NEIGHBORHOOD_BITS_LOG)
+#define NEIGHBORHOOD_WORDS    (NEIGHBORHOOD_BITS/64)
+
+/**
+ * Vertices with at least this number of neighbors get a precomputed neighborhood bitmap sketch
+ */
+#define NEIGHBORHOOD_HUB_DEGREE 128
+
+
+/**
+ * Default number of bins of the per-vertice neighborhood sketches computed by wsd-create; sketch
+ * sizes are always rounded up to a multiple of SKETCH_ALIGN so they can be compared with vector
+ * instructions
+ */
+#define SKETCH_SIZE  32
+#define SKETCH_ALIGN 8
+
+/**
+ * Bin value of empty sketch bins
+ */
+#define SKETCH_EMPTY 0xFFFFFFFFu
+
+/**
+ * Suffix of the sketch file stored next to the graph dump
+ */
+#define SKETCH_SUFFIX ".sketches"
+
+
+/**
+ * Default dimension of the vertice embeddings computed by wsd-create; dimensions are always
+ * rounded up to a multiple of EMBEDDING_ALIGN (one AVX2 register of 8bit values)
+ */
+#define EMBEDDING_DIM   64
+#define EMBEDDING_ALIGN 32
+
+/**
+ * Default number and length of the truncated random walks started at each vertice for computing
+ * its embedding
+ */
+#define EMBEDDING_WALKS       16
+#define EMBEDDING_WALK_LENGTH 6
+
+/**
+ * Suffix of the embedding file stored next to the graph dump
+ */
+#define EMBEDDING_SUFFIX ".embeddings"
+
+
+/**
+ * Number of URIs resolved together in batch lookups (rgraph::get_vertice_ids); the hash table
+ * accesses of all URIs in a batch are prefetched before the first one is compared
+ */
+#define RESOLVE_BATCH 16
+
+/**
+ * Relatedness tasks are handed out to the worker threads in chunks taking about this time in
+ * nanoseconds (estimated from the tasks already computed), but at most TASK_CHUNK_MAX tasks at once
+ */
+#define TASK_CHUNK_TIME 50000
+#define TASK_CHUNK_MAX  256
+
+/**
+ * Shortest path tasks of requests with at least this maximum distance are computed in parallel
+ * (delta-stepping) by otherwise idle worker threads once fewer tasks than threads remain
+ */
+#define DELTA_STEPPING_MIN_DIST 3
+
+/**
+ * Number of vertices handed out to a thread at once in the parallel shortest path computation
+ */
+#define DELTA_STEPPING_CHUNK 256
+
+/**
+ * Disambiguation graphs with up to this number of vertices keep a dense adjacency matrix for the
+ * centrality computations; larger ones only use the sparse (CSR) representation
+ */
+#define CENTRALITY_DENSE_MAX 512
+
+/**
+ * Power iterations for eigenvector and PageRank centrality stop when the scores change by less
+ * than CENTRALITY_EPSILON in total, or after CENTRALITY_MAX_ITERATIONS iterations
+ */
+#define CENTRALITY_EPSILON        1e-9
+#define CENTRALITY_MAX_ITERATIONS 1000
+
+/**
+ * Betweenness centrality sums up the contributions of the shortest path searches in this many
+ * blocks of sources, which are the tasks handed out to the relatedness workers
+ */
+#define CENTRALITY_BLOCKS 64
+
+/**
+ * Size of the relatedness cache shared by all requests (number of entries of 32 bytes); the cache
+ * is divided into RELATEDNESS_CACHE_SHARDS independently locked shards, and a value can be stored
+ * in RELATEDNESS_CACHE_WAYS different entries of its shard
+ */
+#define RELATEDNESS_CACHE_ENTRIES (1<<21)
+#define RELATEDNESS_CACHE_SHARDS  64
+#define RELATEDNESS_CACHE_WAYS    8
+
+/**
+ * Number of independently locked shards of the relatedness computations in progress (flights)
+ * and of the pairs pending in submitted batches; a source vertex always maps to the same shard
+ */
+#define RELATEDNESS_FLIGHT_SHARDS 64
+
+/**
+ * Suffix of the file with precomputed relatedness values stored next to the graph dump
+ */
+#define RELATEDNESS_SUFFIX ".relatedness"
+
+/**
+ * Default interval in seconds at which the disambiguation server writes the relatedness cache to
+ * the relatedness file (0 to disable)
+ */
+#define RELATEDNESS_SNAPSHOT_INTERVAL 600
+
+/**
+ * Seconds the server keeps the resolved candidates and relatedness values of a session after its
+ * last request (see DisambiguationRequest.session)
+ */
+#define SESSION_TTL 300
+
+/**
+ * Maximum number of sessions the server keeps; beyond, the least recently used sessions are dropped
+ */
+#define SESSION_MAX 4096
+
+/**
+ * Memory of the response cache of the disambiguation server in bytes (0 to disable); the cache is
+ * divided into RESPONSE_CACHE_SHARDS independently locked shards with one entry for every
+ * RESPONSE_CACHE_SLOT bytes, a key can be stored in one of RESPONSE_CACHE_WAYS entries, and
+ * responses larger than RESPONSE_CACHE_MAX_RESPONSE bytes are not cached
+ */
+#define RESPONSE_CACHE_SIZE         (64<<20)
+#define RESPONSE_CACHE_SHARDS       16
+#define RESPONSE_CACHE_SLOT         1024
+#define RESPONSE_CACHE_WAYS         4
+#define RESPONSE_CACHE_MAX_RESPONSE (1<<20)
+
+/**
+ * Cost model of the AUTO relatedness algorithm: estimated nanoseconds per vertice of the graph for
+ * setting up a search (SHORTEST_PATH, DFS), per adjacency entry visited by a shortest path search
+ * (priority queue) and by a plain scan (DFS, JACCARD, ADAMIC_ADAR), and per pair for the constant
+ * time algorithms (SKETCH, PARTITION)
+ */
+#define AUTO_COST_VERTICE      1
+#define AUTO_COST_SEARCH       500
+#define AUTO_COST_NEIGHBORHOOD 10
+#define AUTO_COST_CONSTANT     50
+
+/**
+ * Default time budget in milliseconds for the relatedness computations of a request with AUTO
+ * relatedness (see DisambiguationRequest.budget)
+ */
+#define AUTO_BUDGET 100
+
+/**
+ * Load-aware degradation (see disambiguation/wsd_load.h): number of relatedness batches waiting for
+ * the workers from which expensive relatedness algorithms are replaced by cheaper ones
+ * (LOAD_DEGRADE) and all requests use constant time relatedness with half the maxdist
+ * (LOAD_MINIMAL), and number of requests in progress beyond which requests are rejected
+ */
+#define LOAD_DEGRADE 4
+#define LOAD_MINIMAL 16
+#define LOAD_REJECT  64
+
+/**
+ * Pipeline of a connection of the disambiguation server: number of requests of the connection
+ * that are disambiguated concurrently (PIPELINE_DEPTH), and number of requests parsed ahead and
+ * waiting for disambiguation or for their response to be sent (PIPELINE_QUEUE)
+ */
+#define PIPELINE_DEPTH 2
+#define PIPELINE_QUEUE 8
+
+/**
+ * Largest message accepted over a connection or from a request log, in bytes; the length prefix
+ * of a message is checked against it before any memory is allocated
+ */
+#define MESSAGE_MAX_SIZE ((size_t)64<<20)
+
 //#define GRAPH_MODE IGRAPH_UNDIRECTED
 #define GRAPH_MODE IGRAPH_DIRECTED
 
@@ -0,0 +1,175 @@
+#include <iostream>
+#include <string.h>
+
+#include "embeddings_walks.h"
+#include "../graph/embeddings.h"
+#include "../threading/thread.h"
+
+namespace mico {
+  namespace graph {
+    namespace embedding {
+
+      // 64bit integer hash / random number generator step (splitmix64)
+      static inline uint64_t mix(uint64_t x) {
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+      }
+
+
+      /**
+       * Transition table of the random walks: for each vertice the list of incident neighbors
+       * (outgoing and incoming edges) with cumulative transition weights.
+       */
+      struct transitions {
+	long int* offsets;
+	int*      targets;
+	float*    cumulative;
+
+	transitions(rgraph_weighted& g) {
+	  long int node, i, j, k = 0, eid;
+	  igraph_t* graph = g.graph;
+	  bool weighted = g.weights.size() == (size_t)igraph_ecount(graph);
+	  float sum;
+
+	  offsets    = new long int[g.num_vertices + 1];
+	  targets    = new int[2 * (long int)igraph_ecount(graph) + 1];
+	  cumulative = new float[2 * (long int)igraph_ecount(graph) + 1];
+
+	  for(node=0; node<g.num_vertices; node++) {
+	    offsets[node] = k;
+	    sum = 0.0f;
+
+	    j=(long int) VECTOR(graph->os)[node+1];
+	    for (i=(long int) VECTOR(graph->os)[node]; i<j; i++, k++) {
+	      eid = (long int)VECTOR(graph->oi)[i];
+	      targets[k]    = VECTOR(graph->to)[eid];
+	      sum          += weighted && g.weights[eid] > 0.0 ? 1.0 / g.weights[eid] : 1.0;
+	      cumulative[k] = sum;
+	    }
+
+	    j=(long int) VECTOR(graph->is)[node+1];
+	    for (i=(long int) VECTOR(graph->is)[node]; i<j; i++, k++) {
+	      eid = (long int)VECTOR(graph->ii)[i];
+	      targets[k]    = VECTOR(graph->from)[eid];
+	      sum          += weighted && g.weights[eid] > 0.0 ? 1.0 / g.weights[eid] : 1.0;
+	      cumulative[k] = sum;
+	    }
+	  }
+	  offsets[g.num_vertices] = k;
+	}
+
+	~transitions() {
+	  delete[] offsets;
+	  delete[] targets;
+	  delete[] cumulative;
+	}
+
+	// choose the next vertice for the given random number, -1 if the vertice has no neighbors
+	inline int next(int v, uint64_t r) const {
+	  long int lo = offsets[v], hi = offsets[v+1], mid;
+	  if(lo == hi) {
+	    return -1;
+	  }
+
+	  float x = (float)((r >> 11) * (1.0 / 9007199254740992.0)) * cumulative[hi-1];
+	  hi--;
+	  while(lo < hi) {
+	    mid = (lo + hi) >> 1;
+	    if(cumulative[mid] <= x) {
+	      lo = mid + 1;
+	    } else {
+	      hi = mid;
+	    }
+	  }
+	  return targets[lo];
+	}
+      };
+
+
+      /**
+       * Computes the embeddings of a range of vertices.
+       */
+      class walk_worker : public virtual mico::threading::thread {
+
+	const transitions& trans;
+	embeddings*        result;
+	int                walks, length;
+	uint64_t           seed;
+	int                first, last;
+
+      public:
+
+	walk_worker(const transitions& trans, embeddings* result, int walks, int length, uint64_t seed, int start, int end)
+	  : thread(), trans(trans), result(result), walks(walks), length(length), seed(seed), first(start), last(end) {};
+
+	void run() {
+	  int v, w, s, i, b, cur, dim = result->dim;
+	  uint64_t rng, bits;
+	  float* acc = new float[dim];
+
+	  for(v=first; v<last; v++) {
+	    memset(acc, 0, dim * sizeof(float));
+
+	    for(w=0; w<walks; w++) {
+	      rng = mix(seed ^ mix(((uint64_t)v << 20) + w));
+	      cur = v;
+
+	      for(s=1; s<=length; s++) {
+		rng = mix(rng);
+		cur = trans.next(cur, rng);
+		if(cur < 0) {
+		  break;
+		}
+
+		// add the +1/-1 projection vector of the visited vertice, damped by the step
+		float damp = 1.0f / s;
+		for(i=0; i<dim; i+=64) {
+		  bits = mix(seed + mix((uint64_t)cur * 0x100000001b3ULL + i));
+		  for(b=0; b<64 && i+b<dim; b++) {
+		    acc[i+b] += (bits >> b) & 1 ? damp : -damp;
+		  }
+		}
+	      }
+	    }
+
+	    result->set(v, acc);
+	  }
+
+	  delete[] acc;
+	};
+      };
+
+
+      void rgraph_embeddings_walks::compute_embeddings(int dim, int walks, int length, unsigned long seed, int num_threads) {
+	int t;
+
+	std::cout << "calculating embeddings of dimension " << dim << " for " << num_vertices << " vertices (" << walks << " walks of length " << length << ", seed " << seed << ") ... \n";
+
+	std::cout << "- building transition table ... \n";
+	transitions trans(*this);
+
+	embeddings* result = new embeddings(num_vertices, dim);
+
+	std::cout << "- walking ... \n";
+	walk_worker** workers = new walk_worker*[num_threads];
+	for(t=0; t<num_threads; t++) {
+	  workers[t] = new walk_worker(trans, result, walks, length, seed,
+				       (int)((long int)num_vertices * t / num_threads),
+				       (int)((long int)num_vertices * (t+1) / num_threads));
+	  workers[t]->start();
+	}
+	for(t=0; t<num_threads; t++) {
+	  workers[t]->join();
+	  delete workers[t];
+	}
+	delete[] workers;
+
+	delete embedding;
+	embedding = result;
+      }
+
+    }
+  }
+}
@@ -0,0 +1,46 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_EMBEDDINGS_WALKS_H
+#define HAVE_EMBEDDINGS_WALKS_H 1
+
+#include "../graph/rgraph.h"
+
+namespace mico {
+  namespace graph {
+    namespace embedding {
+
+      /**
+       * Compute low-dimensional vertice embeddings from truncated random walks over the weighted
+       * graph (ignoring edge direction). Each walk step moves to a neighbor with a probability
+       * proportional to the inverse edge weight, so strongly related vertices are visited more
+       * often. Every vertice has a fixed pseudo-random +1/-1 projection vector derived from the
+       * seed; the embedding of a vertice is the sum of the projection vectors of all vertices
+       * visited by its walks, damped by the distance (step) from the start. Vertices with similar
+       * walk distributions therefore end up with similar embeddings (random projection of the
+       * walk co-occurrence matrix).
+       *
+       * All random numbers are derived from the seed, the start vertice and the walk number, and
+       * each thread only writes the embeddings of its own vertices, so the result is
+       * deterministic for a given seed independent of the number of threads.
+       */
+      class rgraph_embeddings_walks : public virtual rgraph_complete {
+
+      public:
+
+	/**
+	 * Initialise an empty relatedness graph, ready for being updated.
+	 */
+	rgraph_embeddings_walks(int reserve_vertices = 0, int reserve_edges = 0) : rgraph(reserve_vertices, reserve_edges) {};
+
+
+	/**
+	 * Compute embeddings of the given dimension using the given number of walks of the given
+	 * length per vertice, using num_threads threads in parallel.
+	 */
+	void compute_embeddings(int dim, int walks, int length, unsigned long seed, int num_threads);
+
+      };
+    }
+  }
+}
+
+#endif
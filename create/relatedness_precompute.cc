@@ -0,0 +1,135 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <float.h>
+#include <string.h>
+
+#include "relatedness_precompute.h"
+#include "../graph/relatedness_table.h"
+#include "../relatedness/relatedness_shortest_path.h"
+#include "../relatedness/relatedness_dfs.h"
+#include "../relatedness/relatedness_neighborhood.h"
+#include "../threading/thread.h"
+
+namespace mico {
+  namespace graph {
+    namespace precompute {
+
+      // algorithms whose values are cached by the disambiguation server; the numbers are the
+      // RelatednessAlgorithm values of the disambiguation protocol
+      static const struct {
+	const char* name;
+	int         number;
+	bool        symmetric;
+      } algorithms[] = {
+	{ "shortest_path", 1, false },
+	{ "dfs",           4, false },
+	{ "jaccard",       5, true  },
+	{ "adamic_adar",   6, true  },
+	{ NULL,            0, false }
+      };
+
+
+      /**
+       * Computes the relatedness of a range of the records with its own instance of the algorithm.
+       */
+      class relatedness_worker : public virtual mico::threading::thread {
+
+	mico::relatedness::base* algorithm;
+	relatedness_table::record* records;
+	long first, last;
+
+      public:
+
+	relatedness_worker(mico::relatedness::base* algorithm, relatedness_table::record* records, long first, long last)
+	  : thread(), algorithm(algorithm), records(records), first(first), last(last) {};
+
+	~relatedness_worker() {
+	  delete algorithm;
+	}
+
+	void run() {
+	  for(long i=first; i<last; i++) {
+	    records[i].relatedness = algorithm->relatedness((int)(records[i].pair >> 32), (int)(uint32_t)records[i].pair);
+	  }
+	};
+      };
+
+
+      bool rgraph_relatedness_precompute::compute_relatedness(const char* pairsfile, const char* algorithm, int max_dist, const char* filename, int num_threads) {
+	std::vector<relatedness_table::record> records;
+	relatedness_table::record r;
+	std::string line, from, to;
+	long skipped = 0;
+	int a, f, t;
+
+	for(a=0; algorithms[a].name != NULL && strcmp(algorithms[a].name, algorithm) != 0; a++);
+	if(algorithms[a].name == NULL) {
+	  std::cerr << "unknown relatedness algorithm " << algorithm << "\n";
+	  return false;
+	}
+
+	std::ifstream is(pairsfile);
+	if(!is) {
+	  std::cerr << "could not read pairs file " << pairsfile << "\n";
+	  return false;
+	}
+
+	// resolve the pairs; symmetric algorithms are looked up with the smaller id first
+	r.config      = relatedness_table::config(algorithms[a].number, max_dist);
+	r.reserved    = 0;
+	r.relatedness = DBL_MAX;
+	r.cutoff      = DBL_MAX;
+	while(std::getline(is, line)) {
+	  std::istringstream ls(line);
+	  if(!(ls >> from >> to)) {
+	    continue;
+	  }
+
+	  f = get_vertice_id(from.c_str());
+	  t = get_vertice_id(to.c_str());
+	  if(f < 0 || t < 0) {
+	    skipped++;
+	    continue;
+	  }
+	  if(algorithms[a].symmetric && t < f) {
+	    std::swap(f, t);
+	  }
+
+	  r.pair = relatedness_table::pair(f, t);
+	  records.push_back(r);
+	}
+
+	std::cout << "calculating " << algorithm << " relatedness (maximum distance " << max_dist << ") of " << records.size()
+		  << " pairs (" << skipped << " pairs with unknown URIs skipped) ... \n";
+
+	relatedness_worker** workers = new relatedness_worker*[num_threads];
+	for(t=0; t<num_threads; t++) {
+	  mico::relatedness::base* alg;
+	  switch(algorithms[a].number) {
+	  case 1:  alg = new mico::relatedness::shortest_path(this, max_dist); break;
+	  case 4:  alg = new mico::relatedness::dfs(this, max_dist); break;
+	  case 5:  alg = new mico::relatedness::jaccard(this, max_dist); break;
+	  default: alg = new mico::relatedness::adamic_adar(this, max_dist); break;
+	  }
+
+	  workers[t] = new relatedness_worker(alg, records.data(),
+					      (long int)records.size() * t / num_threads,
+					      (long int)records.size() * (t+1) / num_threads);
+	  workers[t]->start();
+	}
+	for(t=0; t<num_threads; t++) {
+	  workers[t]->join();
+	  delete workers[t];
+	}
+	delete[] workers;
+
+	return relatedness_table::dump_file(filename, fingerprint(), records);
+      }
+
+    }
+  }
+}
@@ -0,0 +1,43 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_RELATEDNESS_PRECOMPUTE_H
+#define HAVE_RELATEDNESS_PRECOMPUTE_H 1
+
+#include "../graph/rgraph.h"
+
+namespace mico {
+  namespace graph {
+    namespace precompute {
+
+      /**
+       * Compute the relatedness of a list of pairs of vertices (e.g. the most frequent candidate
+       * pairs of past requests) and write them to a relatedness file next to the graph dump, which
+       * the disambiguation server maps on startup and uses as if the values were in its cache.
+       *
+       * The pairs file contains one pair per line, given as two URIs separated by whitespace;
+       * pairs with URIs not contained in the graph are skipped. Values are computed without
+       * cutoff, so they can be used by requests with any cutoff.
+       */
+      class rgraph_relatedness_precompute : public virtual rgraph_complete {
+
+      public:
+
+	/**
+	 * Initialise an empty relatedness graph, ready for being updated.
+	 */
+	rgraph_relatedness_precompute(int reserve_vertices = 0, int reserve_edges = 0) : rgraph(reserve_vertices, reserve_edges) {};
+
+
+	/**
+	 * Compute the relatedness of the pairs listed in pairsfile with the given algorithm
+	 * (shortest_path, dfs, jaccard or adamic_adar) and maximum distance, using num_threads
+	 * threads in parallel, and write them to the relatedness file with the given name. Returns
+	 * false if the algorithm is unknown or a file cannot be read or written.
+	 */
+	bool compute_relatedness(const char* pairsfile, const char* algorithm, int max_dist, const char* filename, int num_threads);
+
+      };
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,114 @@
+#include <iostream>
+#include <string.h>
+
+#include "sketches_minhash.h"
+#include "../graph/adjacency.h"
+#include "../graph/sketches.h"
+#include "../threading/thread.h"
+
+namespace mico {
+  namespace graph {
+    namespace sketching {
+
+      // 32bit integer hash (finalizer of MurmurHash3)
+      static inline uint32_t hash(uint32_t v) {
+	v ^= v >> 16;
+	v *= 0x85ebca6b;
+	v ^= v >> 13;
+	v *= 0xc2b2ae35;
+	v ^= v >> 16;
+	return v;
+      }
+
+      static inline void add_vertice(uint32_t* sketch, int size, uint32_t v) {
+	uint32_t h   = hash(v);
+	uint32_t bin = (uint32_t)(((uint64_t)h * size) >> 32);
+	if(h < sketch[bin]) {
+	  sketch[bin] = h;
+	}
+      }
+
+
+      /**
+       * Computes the sketches of a range of vertices. In the first hop, sketches are computed
+       * from the adjacency; in each following hop, the sketches of the previous hop are merged.
+       */
+      class sketch_worker : public virtual mico::threading::thread {
+
+	const adjacency* adj;
+	sketches*        result;
+	const sketches*  previous;
+	int              first, last;
+
+      public:
+
+	sketch_worker(const adjacency* adj, sketches* result, const sketches* previous, int start, int end)
+	  : thread(), adj(adj), result(result), previous(previous), first(start), last(end) {};
+
+	void run() {
+	  int v, k, i, size = result->size;
+
+	  for(v=first; v<last; v++) {
+	    uint32_t* s = result->get(v);
+	    const uint32_t* n = adj->neighbors(v);
+
+	    if(previous == NULL) {
+	      add_vertice(s, size, v);
+	      for(k=0; k<adj->degree(v); k++) {
+		add_vertice(s, size, n[k]);
+	      }
+	    } else {
+	      memcpy(s, previous->get(v), size * sizeof(uint32_t));
+	      for(k=0; k<adj->degree(v); k++) {
+		const uint32_t* p = previous->get(n[k]);
+		for(i=0; i<size; i++) {
+		  s[i] = p[i] < s[i] ? p[i] : s[i];
+		}
+	      }
+	    }
+	  }
+	};
+      };
+
+
+      void rgraph_sketches_minhash::compute_sketches(int size, int hops, int num_threads) {
+	int h, t;
+
+	std::cout << "calculating " << hops << "-hop neighborhood sketches of size " << size << " for " << num_vertices << " vertices ... \n";
+
+	const adjacency* adj = get_adjacency();
+
+	sketches* current  = NULL;
+	sketches* previous = NULL;
+
+	sketch_worker** workers = new sketch_worker*[num_threads];
+
+	for(h=1; h<=hops; h++) {
+	  std::cout << "- computing hop " << h << " ... \n";
+
+	  current = new sketches(num_vertices, size, h);
+
+	  for(t=0; t<num_threads; t++) {
+	    workers[t] = new sketch_worker(adj, current, previous,
+					   (int)((long int)num_vertices * t / num_threads),
+					   (int)((long int)num_vertices * (t+1) / num_threads));
+	    workers[t]->start();
+	  }
+	  for(t=0; t<num_threads; t++) {
+	    workers[t]->join();
+	    delete workers[t];
+	  }
+
+	  delete previous;
+	  previous = current;
+	}
+
+	delete[] workers;
+
+	delete sketch;
+	sketch = current;
+      }
+
+    }
+  }
+}
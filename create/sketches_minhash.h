@@ -0,0 +1,39 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_SKETCHES_MINHASH_H
+#define HAVE_SKETCHES_MINHASH_H 1
+
+#include "../graph/rgraph.h"
+
+namespace mico {
+  namespace graph {
+    namespace sketching {
+
+      /**
+       * Compute MinHash sketches (one-permutation hashing) of the 1- or 2-hop neighborhood of each
+       * vertice, ignoring edge direction. Each vertice is hashed once; the sketch of a vertice
+       * keeps the minimum hash per bin over the vertice itself and all its neighbors. 2-hop
+       * sketches are obtained by merging (bin-wise minimum) the 1-hop sketches of all neighbors,
+       * so the cost is O(|E| * size) independent of the size of the 2-hop neighborhoods.
+       */
+      class rgraph_sketches_minhash : public virtual rgraph_complete {
+
+      public:
+
+	/**
+	 * Initialise an empty relatedness graph, ready for being updated.
+	 */
+	rgraph_sketches_minhash(int reserve_vertices = 0, int reserve_edges = 0) : rgraph(reserve_vertices, reserve_edges) {};
+
+
+	/**
+	 * Compute the neighborhood sketches with the given number of bins for neighborhoods of
+	 * the given number of hops (1 or 2), using num_threads threads in parallel.
+	 */
+	void compute_sketches(int size, int hops, int num_threads);
+
+      };
+    }
+  }
+}
+
+#endif
@@ -27,6 +27,9 @@
 #include "parse_graph.h"
 #include "weights_combi.h"
 #include "clustering_metis.h"
+#include "sketches_minhash.h"
+#include "embeddings_walks.h"
+#include "relatedness_precompute.h"
 
 #ifdef TIMING
 #include <boost/timer/timer.hpp>
@@ -41,6 +44,9 @@ using boost::timer::nanosecond_type;
 #define MODE_RESTORE 4
 #define MODE_WEIGHTS 8
 #define MODE_CLUSTERS 16
+#define MODE_SKETCHES 32
+#define MODE_EMBEDDINGS 64
+#define MODE_RELATEDNESS 128
 
 
 // internal representation of an RDF file
@@ -57,14 +63,17 @@ using namespace mico::graph;
 using namespace mico::graph::rdf;
 using namespace mico::graph::weights;
 using namespace mico::graph::clustering;
+using namespace mico::graph::sketching;
+using namespace mico::graph::embedding;
+using namespace mico::graph::precompute;
 using namespace mico::threading;
 
 
 
 /**
- * Merged class for computing weights and clusters
+ * Merged class for computing weights, clusters, sketches, embeddings and relatedness values
  */
-class rgraph_cw : public rgraph_weights_combi, public rgraph_clustering_metis {
+class rgraph_cw : public rgraph_weights_combi, public rgraph_clustering_metis, public rgraph_sketches_minhash, public rgraph_embeddings_walks, public rgraph_relatedness_precompute {
   
 };
 
@@ -136,7 +145,7 @@ public:
 
 
 void usage(char *cmd) {
-  printf("Usage: %s [-f format] [-o outprefix] [-i inprefix] [-p] [-w] [-c] [-e num] [-v num] [-t threads] rdffiles...\n", cmd);
+  printf("Usage: %s [-f format] [-o outprefix] [-i inprefix] [-p] [-w] [-c] [-s size] [-d hops] [-m dim] [-r seed] [-x pairsfile] [-a algorithm] [-l maxdist] [-e num] [-v num] [-t threads] rdffiles...\n", cmd);
   printf("Options:\n");
   printf(" -f format       the format of the RDF files (turtle,rdfxml,ntriples,trig,json)\n");
   printf(" -o outprefix    prefix of the output files to write the result to (e.g. ~/dumps/dbpedia)\n");
@@ -146,6 +155,13 @@ void usage(char *cmd) {
   printf(" -e edges        estimated number of graph edges (for improved efficiency)\n");
   printf(" -w              calculate weights before writing result\n");
   printf(" -c              calculate clusters before writing result (requires weights)\n");
+  printf(" -s size         calculate neighborhood sketches with the given number of bins before writing result\n");
+  printf(" -d hops         number of hops of the neighborhoods represented by sketches (1 or 2, default 2)\n");
+  printf(" -m dim          calculate random walk embeddings with the given dimension before writing result (requires weights)\n");
+  printf(" -r seed         random seed for computing embeddings (default 1)\n");
+  printf(" -x pairsfile    precompute the relatedness of the pairs of URIs listed in the file for the disambiguation server (requires weights)\n");
+  printf(" -a algorithm    relatedness algorithm for precomputing (shortest_path, dfs, jaccard, adamic_adar; default shortest_path)\n");
+  printf(" -l maxdist      maximum distance for precomputing relatedness (default 3)\n");
   printf(" -p              print statistics about training when finished\n");
 }
 
@@ -163,6 +179,13 @@ int main(int argc, char** argv) {
   int reserve_edges = 1<<16;
   int reserve_vertices = 1<<12;
   int num_clusters = 8;
+  int sketch_size = SKETCH_SIZE;
+  int sketch_hops = 2;
+  int embedding_dim = EMBEDDING_DIM;
+  unsigned long embedding_seed = 1;
+  char *pairsfile = NULL;
+  const char *relatedness_algorithm = "shortest_path";
+  int relatedness_dist = 3;
 
   int num_threads = NUM_THREADS;
 
@@ -172,7 +195,7 @@ int main(int argc, char** argv) {
 
 
   // read options from command line
-  while( (opt = getopt(argc,argv,"pwc:f:o:i:e:v:t:")) != -1) {
+  while( (opt = getopt(argc,argv,"pwc:s:d:m:r:x:a:l:f:o:i:e:v:t:")) != -1) {
     switch(opt) {
     case 'o':
       ofile = optarg;
@@ -192,6 +215,30 @@ int main(int argc, char** argv) {
       mode |= MODE_CLUSTERS;
       num_clusters = atoi(optarg);
       break;
+    case 's':
+      mode |= MODE_SKETCHES;
+      sketch_size = atoi(optarg);
+      break;
+    case 'd':
+      sketch_hops = atoi(optarg);
+      break;
+    case 'm':
+      mode |= MODE_EMBEDDINGS;
+      embedding_dim = atoi(optarg);
+      break;
+    case 'r':
+      embedding_seed = strtoul(optarg, NULL, 10);
+      break;
+    case 'x':
+      mode |= MODE_RELATEDNESS;
+      pairsfile = optarg;
+      break;
+    case 'a':
+      relatedness_algorithm = optarg;
+      break;
+    case 'l':
+      relatedness_dist = atoi(optarg);
+      break;
     case 'f':
       format = optarg;
       break;
@@ -271,6 +318,48 @@ int main(int argc, char** argv) {
     }
   }
 
+  if(mode & MODE_SKETCHES) {
+    std::cout << "computing neighborhood sketches ... ";
+    std::cout.flush();
+    start = clock();
+    graph.compute_sketches(sketch_size, sketch_hops, num_threads);
+    end = clock();
+
+    std::cout << "done (" << ((end-start) * 1000 / CLOCKS_PER_SEC) << "ms)!\n";
+  }
+
+  if(mode & MODE_EMBEDDINGS) {
+    std::cout << "computing embeddings ... ";
+    if(mode & MODE_WEIGHTS) {
+      std::cout.flush();
+      start = clock();
+      graph.compute_embeddings(embedding_dim, EMBEDDING_WALKS, EMBEDDING_WALK_LENGTH, embedding_seed, num_threads);
+      end = clock();
+
+      std::cout << "done (" << ((end-start) * 1000 / CLOCKS_PER_SEC) << "ms)!\n";
+    } else {
+      std::cout << "cannot compute embeddings without weights\n";
+    }
+  }
+
+
+  // the relatedness file is stored next to the output dump, or next to the input dump if the graph
+  // is not written
+  if(mode & MODE_RELATEDNESS) {
+    std::cout << "precomputing relatedness ... ";
+    if((mode & MODE_WEIGHTS) || (mode & MODE_RESTORE)) {
+      std::cout.flush();
+      start = clock();
+      graph.compute_relatedness(pairsfile, relatedness_algorithm, relatedness_dist,
+				(std::string((mode & MODE_DUMP) ? ofile : ifile) + RELATEDNESS_SUFFIX).c_str(), num_threads);
+      end = clock();
+
+      std::cout << "done (" << ((end-start) * 1000 / CLOCKS_PER_SEC) << "ms)!\n";
+    } else {
+      std::cout << "cannot precompute relatedness without weights\n";
+    }
+  }
+
 
   // 4. write out results to the dump files
   if(mode & MODE_DUMP) { 
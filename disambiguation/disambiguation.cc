@@ -1,7 +1,13 @@
 #include <queue>
+#include <vector>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
 
 #include <limits.h>
 #include <float.h>
+#include <time.h>
 #include <igraph/igraph.h>
 
 extern "C" {
@@ -11,10 +17,9 @@ extern "C" {
 #include "../graph/rgraph.h"
 #include "disambiguation.h"
 #include "wsd_relatedness_worker.h"
+#include "wsd_centrality.h"
 #include "../relatedness/relatedness_base.h"
-#include "../relatedness/relatedness_shortest_path.h"
-#include "../relatedness/relatedness_dfs.h"
-#include "../relatedness/relatedness_cluster.h"
+#include "../relatedness/relatedness_embedding.h"
 
 using namespace mico::graph;
 
@@ -32,52 +37,357 @@ inline int ipow(int base, int exp)
     return result;
 }
 
-/** 
- * Compute the degree for each node.
+/**
+ * Order edges of a completed relatedness batch by their relatedness.
+ */
+struct by_relatedness {
+  const mico::disambiguation::wsd::relatedness_batch& batch;
+
+  by_relatedness(const mico::disambiguation::wsd::relatedness_batch& batch) : batch(batch) {};
+
+  inline bool operator()(size_t a, size_t b) const {
+    return batch.get_relatedness(a) < batch.get_relatedness(b);
+  }
+};
+
+/**
+ * Add the edges of the cheap batch to the WSD graph, using the relatedness of edge refined[e] of
+ * the refine batch for edge e where available (refined[e] >= 0 and computed before the deadline).
+ * The other edges keep their cheap relatedness, scaled by the ratio of refined to cheap values
+ * over the pairs where both are known.
  */
-static void compute_degree(igraph_t* graph, igraph_vector_t* weights, igraph_vector_t* results) {
-  long int i, j, node, eid;
-  double v;
-  for(node=0; node<igraph_vcount(graph); node++) {
-    v = 0.0;
+static void merge_edges(const mico::disambiguation::wsd::relatedness_batch& cheap,
+			const mico::disambiguation::wsd::relatedness_batch& refine, const std::vector<long>& refined,
+			double cutoff, igraph_t* wsd_graph, igraph_vector_t* wsd_weights) {
+  double sum_refined = 0.0, sum_cheap = 0.0, scale, r;
+  size_t e;
+
+  for(e = 0; e < cheap.num_edges(); e++) {
+    if(refined[e] >= 0 && refine.is_computed(refined[e]) && refine.get_relatedness(refined[e]) < DBL_MAX && cheap.get_relatedness(e) < DBL_MAX) {
+      sum_refined += refine.get_relatedness(refined[e]);
+      sum_cheap   += cheap.get_relatedness(e);
+    }
+  }
+  scale = sum_refined > 0.0 && sum_cheap > 0.0 ? sum_refined / sum_cheap : 1.0;
 
-    j=(long int) VECTOR(graph->os)[node+1];
-    for (i=(long int) VECTOR(graph->os)[node]; i<j; i++) {
-      eid =  (long int)VECTOR(graph->oi)[i];
+  igraph_vector_t edges;
+  igraph_vector_init(&edges,0);
 
-      v +=  igraph_vector_e(weights,eid);
+  for(e = 0; e < cheap.num_edges(); e++) {
+    if(refined[e] >= 0 && refine.is_computed(refined[e])) {
+      r = refine.get_relatedness(refined[e]);
+    } else {
+      r = cheap.get_relatedness(e) < DBL_MAX ? cheap.get_relatedness(e) * scale : DBL_MAX;
     }
 
-    j=(long int) VECTOR(graph->is)[node+1];
-    for (i=(long int) VECTOR(graph->is)[node]; i<j; i++) {
-      eid = (long int)VECTOR(graph->ii)[i];
-    
-      v +=  igraph_vector_e(weights,eid);
+    if(r < DBL_MAX && r <= cutoff) {
+      igraph_vector_push_back(&edges, cheap.get_edge(e).fromId);
+      igraph_vector_push_back(&edges, cheap.get_edge(e).toId);
+      igraph_vector_push_back(wsd_weights, r);
     }
+  }
+
+  igraph_add_edges(wsd_graph, &edges, 0);
+  igraph_vector_destroy(&edges);
+}
+
+/**
+ * Document-wide state of a disambiguation, shared by its windows.
+ */
+struct WSDDisambiguationRequest::document {
+  mico::graph::rgraph_complete*                    graph;
+  mico::disambiguation::wsd::relatedness_threadpool* pool;
+
+  std::vector<int> offsets;  // node id of the first candidate of each entity (plus the total)
+  std::vector<int> ids;      // vertice id of each candidate in the knowledge graph (-1 if unknown)
+
+  double           cutoff;   // relatedness values above the cutoff add no edge
+
+  // relatedness algorithm of the request (selected by the server for AUTO)
+  DisambiguationRequest::RelatednessAlgorithm algorithm;
+  struct timespec  deadline; // no expensive relatedness tasks are started after this time
+
+  // relatedness values computed together with other requests (or NULL)
+  const mico::disambiguation::wsd::relatedness_batch* shared;
+
+  // edges of the previous window that are reused by the next one (node ids of the document)
+  std::vector<int>    reuse_edges;
+  std::vector<double> reuse_weights;
+
+  // session of the request (or NULL) holding the values of the previous version of the document;
+  // the resolved candidates and relatedness values of this version replace them at the end
+  mico::disambiguation::wsd::session*  session;
+  std::unordered_map<std::string, int> vertices;
+  std::unordered_map<uint64_t, double> values;
+  uint64_t                             reused, computed;
+};
+
+
+// admit a request to the load controller of the server (if any); see load_controller
+static mico::disambiguation::wsd::load_controller::level admit(mico::disambiguation::wsd::relatedness_threadpool* pool, const mico::disambiguation::wsd::services& services) {
+  using namespace  mico::disambiguation::wsd;
+
+  return services.load != NULL ? services.load->admit(pool->backlog()) : load_controller::NORMAL;
+}
+
+static void leave(const mico::disambiguation::wsd::services& services) {
+  if(services.load != NULL) {
+    services.load->leave();
+  }
+}
+
+
+void WSDDisambiguationRequest::disambiguation(rgraph_complete *graph, mico::disambiguation::wsd::relatedness_threadpool *pool,
+					      const mico::disambiguation::wsd::services& services,
+					      const mico::disambiguation::wsd::relatedness_batch* shared) {
+  // the deadline includes the time spent waiting for the cache, the load controller and the session
+  struct timespec arrived;
+  clock_gettime(CLOCK_MONOTONIC, &arrived);
+
+  // identical requests are answered from the response cache without any work on the graph
+  if(cached_response(services)) {
+    std::cout << "answering request from the response cache\n";
+    return;
+  }
+
+  // under load, the request is computed with cheaper parameters or rejected
+  if(degrade(admit(pool, services))) {
+    process(graph, pool, services, shared, arrived);
+  }
+  leave(services);
+}
 
-    igraph_vector_push_back(results,v);
 
+// the next cheaper relatedness algorithm
+static DisambiguationRequest::RelatednessAlgorithm cheaper(DisambiguationRequest::RelatednessAlgorithm algorithm) {
+  switch(algorithm) {
+  case DisambiguationRequest::SHORTEST_PATH:
+    return DisambiguationRequest::DFS;
+  case DisambiguationRequest::DFS:
+  case DisambiguationRequest::JACCARD:
+  case DisambiguationRequest::ADAMIC_ADAR:
+  case DisambiguationRequest::MAXIMUM_FLOW:
+    return DisambiguationRequest::PARTITION;
+  default:
+    return algorithm;
   }
 }
 
-void WSDDisambiguationRequest::disambiguation(rgraph_complete *graph) {
+
+bool WSDDisambiguationRequest::degrade(int level) {
   using namespace  mico::disambiguation::wsd;
 
-  int i, j, t, s, c = 0;
+  if(level == load_controller::REJECTED) {
+    std::cout << "server overloaded, rejecting request\n";
+    set_status(RETRY_LATER);
+    return false;
+  }
+
+  set_status(OK);
+  if(level == load_controller::NORMAL) {
+    return true;
+  }
 
-  int num_vertices=0;           // how many vertices in total
-  int offsets[entities_size()]; // markers to see where in the graph vertice
-			        // list the vertices for a term start
+  RelatednessAlgorithm algorithm = relatedness();
+  int                  dist      = maxdist();
 
-#define get_node_label(x,y) entities(x).candidates(y).uri().c_str()
-#define get_node_id(x,y)    offsets[x]+y
-#define N                   entities_size()
-#define N_w(i)              entities(i).candidates_size()
+  if(level == load_controller::DEGRADED) {
+    if(relatedness() == CASCADE) {
+      set_relatedness(cascade_filter());
+    } else if(relatedness() == AUTO) {
+      set_budget((has_budget() ? budget() : AUTO_BUDGET) / 4);
+    } else {
+      set_relatedness(cheaper(relatedness()));
+    }
+  } else {
+    // constant time relatedness only, fewer pairs
+    if(relatedness() != SKETCH && relatedness() != EMBEDDING) {
+      set_relatedness(PARTITION);
+    }
+    if(maxdist() > 1) {
+      set_maxdist(maxdist() / 2);
+    }
+  }
+
+  if(relatedness() != algorithm || maxdist() != dist || relatedness() == AUTO) {
+    std::cout << "server overloaded, computing with relatedness algorithm " << relatedness() << " and maxdist " << maxdist() << "\n";
+    set_status(DEGRADED);
+  }
+  return true;
+}
+
+
+void WSDDisambiguationRequest::process(rgraph_complete *graph, mico::disambiguation::wsd::relatedness_threadpool *pool,
+				       const mico::disambiguation::wsd::services& services,
+				       const mico::disambiguation::wsd::relatedness_batch* shared,
+				       const struct timespec& arrived) {
+  int i, t;
+
+  document doc;
+  doc.graph  = graph;
+  doc.pool   = pool;
+  doc.shared = shared;
+
+  // relatedness values above the cutoff contribute nothing useful to the dependency graph
+  doc.cutoff = has_cutoff() ? cutoff() : DBL_MAX;
+
+  // values of a session are only kept for algorithms computing each pair on its own
+  doc.session  = NULL;
+  doc.reused   = 0;
+  doc.computed = 0;
+  if(services.sessions != NULL && has_session() && relatedness() != EMBEDDING && relatedness() != CASCADE) {
+    doc.session = services.sessions->acquire(session());
+  }
 
   for(i = 0; i < entities_size(); i++) {
-    offsets[i]    = num_vertices;
-    num_vertices += entities(i).candidates_size();
+    doc.offsets.push_back(doc.ids.size());
+    for(t = 0; t < entities(i).candidates_size(); t++) {
+      doc.ids.push_back(-1);
+    }
   }
+  doc.offsets.push_back(doc.ids.size());
+
+  int num_vertices = doc.ids.size();
+
+  // resolve all candidate URIs to vertice ids in the knowledge graph at once; unknown candidates
+  // (id -1) keep their vertice in the disambiguation graph, but no relatedness tasks are created
+  // for them
+  std::vector<const char*> uris;
+  for(i = 0; i < entities_size(); i++) {
+    for(t = 0; t < entities(i).candidates_size(); t++) {
+      uris.push_back(entities(i).candidates(t).uri().c_str());
+    }
+  }
+  if(num_vertices > 0 && doc.session == NULL) {
+    graph->get_vertice_ids(&uris[0], num_vertices, &doc.ids[0]);
+  } else if(num_vertices > 0) {
+    // only resolve the candidates that are new in this version of the document
+    std::vector<const char*> unresolved;
+    std::vector<int>         positions;
+    for(i = 0; i < num_vertices; i++) {
+      std::unordered_map<std::string, int>::const_iterator it = doc.session->vertices.find(uris[i]);
+      if(it != doc.session->vertices.end()) {
+	doc.ids[i] = it->second;
+      } else {
+	unresolved.push_back(uris[i]);
+	positions.push_back(i);
+      }
+    }
+    if(!unresolved.empty()) {
+      std::vector<int> resolved(unresolved.size());
+      graph->get_vertice_ids(&unresolved[0], unresolved.size(), &resolved[0]);
+      for(size_t k = 0; k < positions.size(); k++) {
+	doc.ids[positions[k]] = resolved[k];
+      }
+    }
+    for(i = 0; i < num_vertices; i++) {
+      doc.vertices[uris[i]] = doc.ids[i];
+    }
+  }
+
+  // AUTO: the most accurate algorithm whose estimated time for the candidate pairs fits the budget
+  // (the constant time PARTITION if the server has no cost model)
+  doc.algorithm = relatedness();
+  if(relatedness() == AUTO && services.costs == NULL) {
+    doc.algorithm = PARTITION;
+  } else if(relatedness() == AUTO) {
+    std::vector<std::pair<int,int> > pairs;
+    int j, s;
+    for(i = 0; i < entities_size(); i++) {
+      for(j = i+1; j <= i+maxdist() && j < entities_size(); j++) {
+	for(t = 0; t < entities(i).candidates_size(); t++) {
+	  for(s = 0; s < entities(j).candidates_size(); s++) {
+	    if(doc.ids[doc.offsets[i]+t] >= 0 && doc.ids[doc.offsets[j]+s] >= 0) {
+	      pairs.push_back(std::make_pair(doc.ids[doc.offsets[i]+t], doc.ids[doc.offsets[j]+s]));
+	    }
+	  }
+	}
+      }
+    }
+
+    double time;
+    doc.algorithm = services.costs->select(pairs, maxdist(), has_budget() ? budget() : AUTO_BUDGET, &time);
+    std::cout << "selected relatedness algorithm " << doc.algorithm << " for " << pairs.size() << " pairs (estimated "
+	      << time / 1e6 << "ms)\n";
+  }
+
+  // session values computed with another algorithm or cutoff are of no use
+  if(doc.session != NULL) {
+    doc.session->use(relatedness_table::config(doc.algorithm, maxdist()), doc.cutoff);
+  }
+
+  int unknown = 0;
+  for(i = 0; i < num_vertices; i++) {
+    if(doc.ids[i] < 0) {
+      unknown++;
+    }
+  }
+  if(unknown > 0) {
+    std::cout << "dropping " << unknown << " candidates not contained in the knowledge graph\n";
+  }
+
+  // expensive relatedness tasks are no longer started after the deadline (milliseconds from the
+  // arrival of the request)
+  doc.deadline          = arrived;
+  doc.deadline.tv_sec  += deadline() / 1000;
+  doc.deadline.tv_nsec += (deadline() % 1000) * 1000000L;
+  if(doc.deadline.tv_nsec >= 1000000000L) {
+    doc.deadline.tv_sec++;
+    doc.deadline.tv_nsec -= 1000000000L;
+  }
+  clear_partial();
+
+  if(!has_window() || window() <= 0 || window() >= entities_size()) {
+    disambiguation(doc, 0, entities_size(), 0, entities_size(), 0, entities_size());
+  } else {
+    // streaming: process the document in overlapping windows; the results of each window are
+    // written back for its core, which has margin entities of context on both sides, and the
+    // relatedness values between entities in the overlap with the next window are reused there
+    int margin = maxdist() > 0 ? maxdist() : 1;
+    int core   = window() - 2 * margin > 0 ? window() - 2 * margin : 1;
+    int first, last, next, reused = 0;
+
+    for(int c = 0; c < entities_size(); c += core) {
+      first = c - margin > 0 ? c - margin : 0;
+      last  = c + core + margin < entities_size() ? c + core + margin : entities_size();
+      next  = c + core - margin > 0 ? c + core - margin : 0; // first entity of the next window
+
+      std::cout << "processing window of entities " << first << " to " << last - 1 << "...\n";
+
+      disambiguation(doc, first, last, reused, next, c, c + core < entities_size() ? c + core : entities_size());
+      reused = last;
+    }
+  }
+
+  if(doc.session != NULL) {
+    std::cout << "reused " << doc.reused << " relatedness values of session " << session() << ", computed " << doc.computed << "\n";
+
+    doc.session->vertices.swap(doc.vertices);
+    doc.session->values.swap(doc.values);
+    services.sessions->release(doc.session, doc.reused, doc.computed);
+  }
+
+  cache_response(services);
+}
+
+
+void WSDDisambiguationRequest::disambiguation(document& doc, int first, int last, int reused, int keep, int emit_first, int emit_last) {
+  using namespace  mico::disambiguation::wsd;
+
+  int i, j, t, s;
+
+  // node ids are local to the window: the first candidate of entity first has id 0
+  int        base         = doc.offsets[first];
+  int        num_vertices = doc.offsets[last] - base;
+  const int* ids          = &doc.ids[0] + base;
+
+  mico::graph::rgraph_complete*  graph = doc.graph;
+  relatedness_threadpool*        pool  = doc.pool;
+
+  double relatedness_cutoff = doc.cutoff;
+
+#define get_node_id(x,y)    (doc.offsets[x]+(y)-base)
+#define N_w(i)              entities(i).candidates_size()
 
   // initialise graph with a vertice for every candidate of every term
   igraph_t wsd_graph;
@@ -91,74 +401,236 @@ void WSDDisambiguationRequest::disambiguation(rgraph_complete *graph) {
 
   std::cout << "building dependency graph...\n";
 
+  // edges between entities before the reused one have been computed by the previous window
+  if(!doc.reuse_edges.empty()) {
+    igraph_vector_t edges;
+    igraph_vector_init(&edges,0);
+    for(size_t e = 0; e < doc.reuse_edges.size(); e++) {
+      igraph_vector_push_back(&edges, doc.reuse_edges[e] - base);
+    }
+    for(size_t e = 0; e < doc.reuse_weights.size(); e++) {
+      igraph_vector_push_back(&wsd_weights, doc.reuse_weights[e]);
+    }
+    igraph_add_edges(&wsd_graph, &edges, 0);
+    igraph_vector_destroy(&edges);
+  }
 
-  // create thread pool
-  relatedness_threadpool_base* pool;
+  if(doc.algorithm == CASCADE) {
+    // score all pairs with the cheap algorithm first, remembering where the candidate pairs of
+    // each pair of entities start
+    relatedness_batch filter(cascade_filter(),maxdist(),DBL_MAX);
+    std::vector<size_t> groups;
+
+    for(i = first; i < last; i++) {
+      for(j = i+1 > reused ? i+1 : reused; j <= i+maxdist() && j < last; j++) {
+	groups.push_back(filter.num_edges());
+	for(t = 0; t < entities(i).candidates_size(); t++) {
+	  if(ids[get_node_id(i,t)] < 0) {
+	    continue;
+	  }
+	  for(s = 0; s < entities(j).candidates_size(); s++) {
+	    if(ids[get_node_id(j,s)] < 0) {
+	      continue;
+	    }
+	    filter.add_task(ids[get_node_id(i,t)], ids[get_node_id(j,s)], get_node_id(i,t), get_node_id(j,s));
+	  }
+	}
+      }
+    }
+    groups.push_back(filter.num_edges());
 
-  switch(relatedness()) {
-  case SHORTEST_PATH:
-    pool = new relatedness_threadpool<mico::relatedness::shortest_path>(graph,wsd_graph,wsd_weights,maxdist());
-    break;
+    pool->execute(filter);
 
-  case DFS:
-    pool = new relatedness_threadpool<mico::relatedness::dfs>(graph,wsd_graph,wsd_weights,maxdist());
-    break;
+    // refine the best pairs of each pair of entities with the expensive algorithm
+    relatedness_batch   refine(cascade_refine(),maxdist(),relatedness_cutoff);
+    if(has_deadline()) {
+      refine.set_deadline(doc.deadline);
+    }
+    std::vector<long>   refined(filter.num_edges(), -1); // edge in the refine batch
+    std::vector<size_t> order;
+    size_t g, e, k;
+
+    for(g = 0; g + 1 < groups.size(); g++) {
+      order.clear();
+      for(e = groups[g]; e < groups[g+1]; e++) {
+	order.push_back(e);
+      }
+      std::sort(order.begin(), order.end(), by_relatedness(filter));
 
-  case PARTITION:
-  default:
-    pool = new relatedness_threadpool<mico::relatedness::cluster>(graph,wsd_graph,wsd_weights,maxdist());
-    break;
-  }
-    
+      for(k = 0; k < order.size(); k++) {
+	double r = filter.get_relatedness(order[k]);
+	if((int)k >= cascade_top() && !(has_cascade_threshold() && r <= cascade_threshold())) {
+	  break;
+	}
 
-  // add tasks to threads in pool (round robin)
-  for(i = 0; i < entities_size(); i++) {
-    for(j = i+1; j <= i+maxdist() && j < entities_size(); j++) {
-      for(t = 0; t < entities(i).candidates_size(); t++) {
-	for(s = 0; s < entities(j).candidates_size(); s++) {
-	  rtask task = {get_node_label(i,t), get_node_label(j,s), get_node_id(i,t),get_node_id(j,s), 0.0};
-	  pool->add_task(task);
+	const redge& edge = filter.get_edge(order[k]);
+	refined[order[k]] = refine.num_edges();
+	refine.add_task(ids[edge.fromId], ids[edge.toId], edge.fromId, edge.toId);
+      }
+    }
+
+    std::cout << "refining " << refine.size() << " of " << filter.size() << " relatedness values...\n";
+
+    pool->execute(refine);
+
+    if(refine.is_expired()) {
+      std::cout << "deadline expired, keeping the cheap relatedness of the remaining pairs\n";
+      set_partial(true);
+    }
+
+    merge_edges(filter, refine, refined, relatedness_cutoff, &wsd_graph, &wsd_weights);
+  } else if(doc.algorithm != EMBEDDING) {
+    // collect tasks and compute them in the thread pool
+    relatedness_batch batch(doc.algorithm,maxdist(),relatedness_cutoff);
+    if(has_deadline()) {
+      batch.set_deadline(doc.deadline);
+    }
+
+    // edges with a relatedness computed together with other requests
+    igraph_vector_t known;
+    igraph_vector_init(&known,0);
+
+    for(i = first; i < last; i++) {
+      for(j = i+1 > reused ? i+1 : reused; j <= i+maxdist() && j < last; j++) {
+	for(t = 0; t < entities(i).candidates_size(); t++) {
+	  if(ids[get_node_id(i,t)] < 0) {
+	    continue;
+	  }
+	  for(s = 0; s < entities(j).candidates_size(); s++) {
+	    if(ids[get_node_id(j,s)] < 0) {
+	      continue;
+	    }
+
+	    double r;
+	    bool   found = doc.shared != NULL && doc.shared->lookup(ids[get_node_id(i,t)], ids[get_node_id(j,s)], &r);
+	    if(!found && doc.session != NULL && doc.session->lookup(ids[get_node_id(i,t)], ids[get_node_id(j,s)], &r)) {
+	      found = true;
+	      doc.reused++;
+	    }
+
+	    if(found) {
+	      if(r < DBL_MAX) {
+		igraph_vector_push_back(&known, get_node_id(i,t));
+		igraph_vector_push_back(&known, get_node_id(j,s));
+		igraph_vector_push_back(&wsd_weights, r);
+	      }
+	      if(doc.session != NULL) {
+		doc.values[relatedness_table::pair(ids[get_node_id(i,t)], ids[get_node_id(j,s)])] = r;
+	      }
+	    } else {
+	      batch.add_task(ids[get_node_id(i,t)], ids[get_node_id(j,s)], get_node_id(i,t), get_node_id(j,s));
+	    }
+	  }
 	}
       }
     }
+
+    igraph_add_edges(&wsd_graph, &known, 0);
+    igraph_vector_destroy(&known);
+
+    if(batch.size() < batch.num_edges()) {
+      std::cout << "computing " << batch.size() << " distinct relatedness values for " << batch.num_edges() << " edges...\n";
+    }
+
+    pool->execute(batch);
+
+    // keep the computed values for the next version of the document (not the cheap values that
+    // replace the expensive ones after the deadline)
+    if(doc.session != NULL) {
+      for(size_t e = 0; e < batch.num_edges(); e++) {
+	if(batch.is_computed(e)) {
+	  const redge& edge = batch.get_edge(e);
+	  doc.values[relatedness_table::pair(ids[edge.fromId], ids[edge.toId])] = batch.get_relatedness(e);
+	  doc.computed++;
+	}
+      }
+    }
+
+    if(!batch.is_expired()) {
+      batch.add_edges(&wsd_graph, &wsd_weights);
+    } else {
+      // deadline expired: score the pairs that have not been computed with a constant time
+      // algorithm; the computed pairs keep their values
+      std::cout << "deadline expired, using cheap relatedness for the remaining pairs\n";
+      set_partial(true);
+
+      relatedness_batch fallback(graph->sketch != NULL ? SKETCH : PARTITION,maxdist(),DBL_MAX);
+      std::vector<long> refined(batch.num_edges(), -1); // edge in the fallback batch
+      for(size_t e = 0; e < batch.num_edges(); e++) {
+	if(!batch.is_computed(e)) {
+	  const redge& edge = batch.get_edge(e);
+	  refined[e] = fallback.num_edges();
+	  fallback.add_task(ids[edge.fromId], ids[edge.toId], edge.fromId, edge.toId);
+	}
+      }
+      pool->execute(fallback);
+
+      merge_edges(batch, fallback, refined, relatedness_cutoff, &wsd_graph, &wsd_weights);
+    }
+  } else {
+    // embeddings: a dot product for each pair of candidates of nearby entities, computed right
+    // here (cheaper than handing the pairs to the thread pool)
+    igraph_vector_t edges;
+    igraph_vector_init(&edges,0);
+
+    for(i = first; i < last; i++) {
+      for(j = i+1 > reused ? i+1 : reused; j <= i+maxdist() && j < last; j++) {
+	for(t = 0; t < entities(i).candidates_size(); t++) {
+	  for(s = 0; s < entities(j).candidates_size(); s++) {
+	    float c = mico::relatedness::embedding::similarity(graph->embedding, ids[get_node_id(i,t)], ids[get_node_id(j,s)]);
+	    if(c > 0.0f && (c < 1.0f ? 1.0 - c : 0.0) <= relatedness_cutoff) {
+	      igraph_vector_push_back(&edges, get_node_id(i,t));
+	      igraph_vector_push_back(&edges, get_node_id(j,s));
+	      igraph_vector_push_back(&wsd_weights, c < 1.0f ? 1.0 - c : 0.0);
+	    }
+	  }
+	}
+      }
+    }
+
+    igraph_add_edges(&wsd_graph, &edges, 0);
+    igraph_vector_destroy(&edges);
   }
 
-  pool->start();
-  pool->join();
+  // keep the edges starting in the overlap with the next window
+  doc.reuse_edges.clear();
+  doc.reuse_weights.clear();
+  for(long e = 0; e < igraph_ecount(&wsd_graph); e++) {
+    if(VECTOR(wsd_graph.from)[e] >= doc.offsets[keep] - base) {
+      doc.reuse_edges.push_back((int)VECTOR(wsd_graph.from)[e] + base);
+      doc.reuse_edges.push_back((int)VECTOR(wsd_graph.to)[e] + base);
+      doc.reuse_weights.push_back(VECTOR(wsd_weights)[e]);
+    }
+  }
 
   // 2. compute centrality for each vertex and write back to
   // candidates
   igraph_vector_t wsd_centralities;
   igraph_vector_init(&wsd_centralities,0);
 
-  igraph_arpack_options_t options;
-  igraph_arpack_options_init(&options);
-
-  igraph_vs_t vertice_s;
-  igraph_vs_all(&vertice_s);
-
-  igraph_real_t value = 1.0;
-
   std::cout << "computing centrality scores using algorithm " << centrality() << "...\n";
 
-  // we support a number of different algorithms through igraph ...
+  // PageRank, eigenvector and degree centrality use power iteration kernels for small graphs,
+  // betweenness and closeness run one shortest path search per vertice in the thread pool
+  centrality_graph kernels(&wsd_graph, &wsd_weights);
+  igraph_vector_resize(&wsd_centralities, kernels.size());
+
   switch(centrality()) {
   case PAGERANK:
-    // igraph version <0.7 and >= 0.5
-    igraph_pagerank(&wsd_graph, &wsd_centralities, &value, igraph_vss_all(), 0, 0.85, &wsd_weights, &options);
+    kernels.pagerank(0.85, VECTOR(wsd_centralities));
     break;
   case CLOSENESS:
-    igraph_closeness(&wsd_graph, &wsd_centralities, igraph_vss_all(), IGRAPH_ALL, &wsd_weights);
+    kernels.closeness(pool, VECTOR(wsd_centralities));
     break;
   case BETWEENNESS:
-    igraph_betweenness(&wsd_graph, &wsd_centralities, igraph_vss_all(), 0, &wsd_weights, 0);
+    kernels.betweenness(pool, VECTOR(wsd_centralities));
     break;
   case EIGENVECTOR:
-    igraph_eigenvector_centrality(&wsd_graph, &wsd_centralities, NULL, 0, 1, &wsd_weights, &options);
+    kernels.eigenvector(VECTOR(wsd_centralities));
     break;
   case DEGREE:
   default:
-    compute_degree(&wsd_graph, &wsd_weights, &wsd_centralities);
+    kernels.degree(VECTOR(wsd_centralities));
     break;
   }  
 
@@ -177,7 +649,7 @@ void WSDDisambiguationRequest::disambiguation(rgraph_complete *graph) {
   // then apply 1.0-value
   igraph_vector_add_constant(&wsd_centralities, 1.0);
 
-  for(i = 0; i<N; i++) {
+  for(i = emit_first; i<emit_last; i++) {
     for(j = 0; j<N_w(i); j++) {
       //      mutable_entities(i)->mutable_candidates(j)->set_confidence(1.0-round(ipow(10,PRECISION)*igraph_vector_e(&wsd_centralities,get_node_id(i,j)))/ipow(10,PRECISION));
       mutable_entities(i)->mutable_candidates(j)->set_confidence(igraph_vector_e(&wsd_centralities,get_node_id(i,j)));
@@ -188,6 +660,245 @@ void WSDDisambiguationRequest::disambiguation(rgraph_complete *graph) {
   igraph_vector_destroy(&wsd_centralities);
   igraph_vector_destroy(&wsd_weights);
   igraph_destroy(&wsd_graph);
+
+#undef get_node_id
+#undef N_w
+}
+
+
+
+bool WSDDisambiguationRequest::shares_relatedness() const {
+  return relatedness() != EMBEDDING && relatedness() != CASCADE && relatedness() != AUTO && !has_deadline();
+}
+
+
+void WSDDisambiguationRequest::add_pairs(rgraph_complete *graph, mico::disambiguation::wsd::relatedness_batch& batch) const {
+  int i, j, t, s, k, n = 0;
+  int offsets[entities_size()];
+
+  for(i = 0; i < entities_size(); i++) {
+    offsets[i] = n;
+    n += entities(i).candidates_size();
+  }
+
+  std::vector<const char*> uris(n);
+  std::vector<int>         ids(n);
+  for(i = 0, k = 0; i < entities_size(); i++) {
+    for(t = 0; t < entities(i).candidates_size(); t++) {
+      uris[k++] = entities(i).candidates(t).uri().c_str();
+    }
+  }
+  if(n > 0) {
+    graph->get_vertice_ids(&uris[0], n, &ids[0]);
+  }
+
+  for(i = 0; i < entities_size(); i++) {
+    for(j = i+1; j <= i+maxdist() && j < entities_size(); j++) {
+      for(t = 0; t < entities(i).candidates_size(); t++) {
+	for(s = 0; s < entities(j).candidates_size(); s++) {
+	  if(ids[offsets[i]+t] >= 0 && ids[offsets[j]+s] >= 0) {
+	    batch.add_pair(ids[offsets[i]+t], ids[offsets[j]+s]);
+	  }
+	}
+      }
+    }
+  }
+}
+
+
+// append the bytes of a value to the canonical form of a request
+static inline void append(std::string& out, const void* data, size_t len) {
+  out.append((const char*)data, len);
+}
+
+/**
+ * Order entities by their (sorted) candidates.
+ */
+struct by_candidates {
+  const std::vector<std::vector<std::string> >& uris;
+
+  by_candidates(const std::vector<std::vector<std::string> >& uris) : uris(uris) {};
+
+  inline bool operator()(int a, int b) const {
+    return uris[a] < uris[b];
+  }
+};
+
+
+std::string WSDDisambiguationRequest::canonical(std::vector<std::pair<int,int> >& order) const {
+  std::string out;
+  int32_t     n = entities_size(), i, t, k;
+
+  // parameters
+  int32_t v[4] = { relatedness(), centrality(), maxdist(), has_window() && window() > 0 && window() < n ? window() : 0 };
+  double  c    = has_cutoff() ? cutoff() : DBL_MAX;
+  append(out, v, sizeof(v));
+  append(out, &c, sizeof(double));
+  if(relatedness() == CASCADE) {
+    int32_t w[3] = { cascade_filter(), cascade_refine(), cascade_top() };
+    double  h    = has_cascade_threshold() ? cascade_threshold() : -1.0;
+    append(out, w, sizeof(w));
+    append(out, &h, sizeof(double));
+  }
+  if(relatedness() == AUTO) {
+    int32_t b = has_budget() ? budget() : AUTO_BUDGET;
+    append(out, &b, sizeof(int32_t));
+  }
+
+  // candidates of every entity in sorted order, keeping their position in the request
+  std::vector<std::vector<std::string> >  uris(n);
+  std::vector<std::vector<std::pair<std::string,int> > > candidates(n);
+  for(i = 0; i < n; i++) {
+    for(t = 0; t < entities(i).candidates_size(); t++) {
+      candidates[i].push_back(std::make_pair(entities(i).candidates(t).uri(), t));
+    }
+    std::sort(candidates[i].begin(), candidates[i].end());
+    for(t = 0; t < (int)candidates[i].size(); t++) {
+      uris[i].push_back(candidates[i][t].first);
+    }
+  }
+
+  // the order of the entities only matters if not all of them are related to each other, or if
+  // the relatedness depends on the direction (pairs are computed from the earlier entity)
+  bool symmetric = mico::disambiguation::wsd::relatedness_batch::is_symmetric(relatedness());
+  if(relatedness() == CASCADE) {
+    symmetric = mico::disambiguation::wsd::relatedness_batch::is_symmetric(cascade_filter())
+      && mico::disambiguation::wsd::relatedness_batch::is_symmetric(cascade_refine());
+  }
+
+  std::vector<int> entities_order(n);
+  for(i = 0; i < n; i++) {
+    entities_order[i] = i;
+  }
+  if(v[3] == 0 && maxdist() >= n - 1 && symmetric) {
+    std::sort(entities_order.begin(), entities_order.end(), by_candidates(uris));
+  }
+
+  order.clear();
+  append(out, &n, sizeof(int32_t));
+  for(k = 0; k < n; k++) {
+    i = entities_order[k];
+
+    int32_t m = candidates[i].size();
+    append(out, &m, sizeof(int32_t));
+    for(t = 0; t < m; t++) {
+      int32_t len = candidates[i][t].first.size();
+      append(out, &len, sizeof(int32_t));
+      out.append(candidates[i][t].first);
+      order.push_back(std::make_pair(i, candidates[i][t].second));
+    }
+  }
+
+  return out;
+}
+
+
+bool WSDDisambiguationRequest::cached_response(const mico::disambiguation::wsd::services& services) {
+  using namespace  mico::disambiguation::wsd;
+
+  // results of requests with a deadline depend on timing
+  if(services.responses == NULL || !services.responses->enabled() || has_deadline()) {
+    return false;
+  }
+
+  std::vector<std::pair<int,int> > order;
+  std::vector<double>              confidences;
+  response_cache::key              key = response_cache::fingerprint(canonical(order));
+
+  if(!services.responses->lookup(key, confidences) || confidences.size() != order.size()) {
+    return false;
+  }
+
+  for(size_t k = 0; k < order.size(); k++) {
+    mutable_entities(order[k].first)->mutable_candidates(order[k].second)->set_confidence(confidences[k]);
+  }
+  clear_partial();
+  set_status(OK);
+  return true;
+}
+
+
+void WSDDisambiguationRequest::cache_response(const mico::disambiguation::wsd::services& services) const {
+  using namespace  mico::disambiguation::wsd;
+
+  if(services.responses == NULL || !services.responses->enabled() || has_deadline()) {
+    return;
+  }
+
+  std::vector<std::pair<int,int> > order;
+  response_cache::key              key = response_cache::fingerprint(canonical(order));
+  std::vector<double>              confidences(order.size());
+
+  for(size_t k = 0; k < order.size(); k++) {
+    confidences[k] = entities(order[k].first).candidates(order[k].second).confidence();
+  }
+  services.responses->insert(key, confidences);
+}
+
+
+void WSDDisambiguationBatch::disambiguation(rgraph_complete *graph, mico::disambiguation::wsd::relatedness_threadpool *pool,
+					    const mico::disambiguation::wsd::services& services) {
+  using namespace  mico::disambiguation::wsd;
+
+  typedef std::pair<std::pair<int,int>, double> configuration; // algorithm, maxdist, cutoff
+
+  std::vector<WSDDisambiguationRequest*>         requests(requests_size());
+  std::vector<relatedness_batch*>                shared(requests_size(), (relatedness_batch*)NULL);
+  std::vector<bool>                              answered(requests_size(), false);
+  std::map<configuration, relatedness_batch*>    batches;
+  int k;
+
+  // the deadlines of all requests count from the arrival of the batch
+  struct timespec arrived;
+  clock_gettime(CLOCK_MONOTONIC, &arrived);
+
+  // the whole batch is admitted at one level of degradation
+  load_controller::level level = admit(pool, services);
+
+  // 1. collect the candidate pairs of all requests, one batch per relatedness configuration
+  for(k = 0; k < requests_size(); k++) {
+    requests[k] = new WSDDisambiguationRequest();
+    requests[k]->Swap(mutable_requests(k));
+
+    // requests answered from the response cache need no relatedness
+    // rejected requests are sent back without results
+    if(requests[k]->cached_response(services) || !requests[k]->degrade(level)) {
+      answered[k] = true;
+      continue;
+    }
+
+    if(requests[k]->shares_relatedness()) {
+      double        cutoff = requests[k]->has_cutoff() ? requests[k]->cutoff() : DBL_MAX;
+      configuration c(std::make_pair((int)requests[k]->relatedness(), requests[k]->maxdist()), cutoff);
+
+      if(batches[c] == NULL) {
+	batches[c] = new relatedness_batch(requests[k]->relatedness(), requests[k]->maxdist(), cutoff);
+      }
+      shared[k] = batches[c];
+      requests[k]->add_pairs(graph, *shared[k]);
+    }
+  }
+
+  // 2. compute the relatedness of all requests
+  for(std::map<configuration, relatedness_batch*>::iterator it = batches.begin(); it != batches.end(); ++it) {
+    std::cout << "computing " << it->second->size() << " distinct relatedness values for a batch of " << requests_size() << " requests...\n";
+    pool->execute(*it->second);
+  }
+
+  // 3. disambiguate each request with the precomputed relatedness values
+  for(k = 0; k < requests_size(); k++) {
+    if(!answered[k]) {
+      requests[k]->process(graph, pool, services, shared[k], arrived);
+    }
+    requests[k]->Swap(mutable_requests(k));
+    delete requests[k];
+  }
+
+  for(std::map<configuration, relatedness_batch*>::iterator it = batches.begin(); it != batches.end(); ++it) {
+    delete it->second;
+  }
+
+  leave(services);
 }
 
 
@@ -207,3 +918,19 @@ std::istream& operator>>(std::istream& in, WSDDisambiguationRequest& r) {
   r.ParseFromIstream(&in);
   return in;
 }
+
+/**
+ * Operator for writing to standard streams
+ */
+std::ostream& operator<<(std::ostream& out, const WSDDisambiguationBatch& b) {
+  b.SerializeToOstream(&out);
+  return out;
+}
+
+/**
+ * Operator for reading from standard streams
+ */
+std::istream& operator>>(std::istream& in, WSDDisambiguationBatch& b) {
+  b.ParseFromIstream(&in);
+  return in;
+}
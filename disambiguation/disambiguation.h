@@ -2,9 +2,14 @@
 #define HAVE_DISAMBIGUATION_H 1
 
 #include <iostream>
+#include <string>
+#include <vector>
+#include <time.h>
 
 #include "../graph/rgraph.h"
 #include "../communication/disambiguation_request.pb.h"
+#include "wsd_relatedness_worker.h"
+#include "wsd_services.h"
 
 
 
@@ -16,15 +21,96 @@
  * mainly adds a method for executing the disambiguation using a knowledge graph.
  */
 class WSDDisambiguationRequest  : public DisambiguationRequest {
-  
+
+  // batches disambiguate their requests together
+  friend class WSDDisambiguationBatch;
+
+  // document-wide state of a disambiguation
+  struct document;
+
+  /**
+   * Disambiguate the window of entities first..last-1 of the document: relatedness is computed
+   * between entities j >= reused (edges between earlier entities are taken from the previous
+   * window), edges starting at entities >= keep are kept for the next window, and confidences
+   * are written back for the entities emit_first..emit_last-1.
+   */
+  void disambiguation(document& doc, int first, int last, int reused, int keep, int emit_first, int emit_last);
+
+  /**
+   * Compute the disambiguation of the request (after the response cache and the load controller
+   * have been consulted). The deadline of the request counts from the time it arrived.
+   */
+  void process(mico::graph::rgraph_complete *graph, mico::disambiguation::wsd::relatedness_threadpool *pool,
+	       const mico::disambiguation::wsd::services& services, const mico::disambiguation::wsd::relatedness_batch* shared,
+	       const struct timespec& arrived);
+
+  /**
+   * Apply the level of degradation the request was admitted with by the load controller: replace
+   * expensive parameters by cheaper ones and set the status of the response. Returns false if the
+   * request is rejected.
+   */
+  bool degrade(int level);
+
+  /**
+   * Canonical form of the request for the response cache: all fields that influence the
+   * confidences, with the candidates of every entity in sorted order (and the entities, too, if
+   * every entity is related to every other one). order[k] is the entity and candidate at position
+   * k of the canonical form.
+   */
+  std::string canonical(std::vector<std::pair<int,int> >& order) const;
+
+  /**
+   * Store the confidences of the request in the response cache of the server (if it can be cached).
+   */
+  void cache_response(const mico::disambiguation::wsd::services& services) const;
+
 public:
   /**
-   * Compute disambiguation for this request using the graph pointed to in the argument. Store
-   * results in the ranking values of the entity candidates.
+   * Compute disambiguation for this request using the graph pointed to in the argument and the
+   * server's relatedness thread pool and services. Store results in the ranking values of the entity
+   * candidates. Relatedness values already computed in the shared batch (if given) are taken
+   * from there. When the server is overloaded, the request is computed with cheaper parameters
+   * or rejected (see load_controller); the status of the response tells.
+   */
+  void disambiguation(mico::graph::rgraph_complete *graph, mico::disambiguation::wsd::relatedness_threadpool *pool,
+		      const mico::disambiguation::wsd::services& services = mico::disambiguation::wsd::services(),
+		      const mico::disambiguation::wsd::relatedness_batch* shared = NULL);
+
+  /**
+   * True if the relatedness of this request can be computed together with other requests (i.e.
+   * it computes the relatedness of every candidate pair independently).
    */
-  void disambiguation(mico::graph::rgraph_complete *graph);
+  bool shares_relatedness() const;
 
+  /**
+   * Add all candidate pairs this request needs the relatedness of to the given batch.
+   */
+  void add_pairs(mico::graph::rgraph_complete *graph, mico::disambiguation::wsd::relatedness_batch& batch) const;
 
+  /**
+   * Look up the request in the response cache of the server and, if found, store the cached
+   * confidences in the candidates. Returns false if the request is not in the cache or cannot be
+   * cached (requests with a deadline, or no response cache).
+   */
+  bool cached_response(const mico::disambiguation::wsd::services& services);
+};
+
+
+/**
+ * This class is an extension of the DisambiguationBatch automatically generated by Protobuf,
+ * adding a method for disambiguating all requests of the batch together.
+ */
+class WSDDisambiguationBatch : public DisambiguationBatch {
+
+public:
+  /**
+   * Compute disambiguation for all requests of the batch. The relatedness of the candidate pairs
+   * of all requests with the same relatedness configuration is computed in a single batch of the
+   * thread pool, each distinct pair only once; the disambiguation graph and centrality are then
+   * computed for each request separately.
+   */
+  void disambiguation(mico::graph::rgraph_complete *graph, mico::disambiguation::wsd::relatedness_threadpool *pool,
+		      const mico::disambiguation::wsd::services& services = mico::disambiguation::wsd::services());
 };
 
 
@@ -38,5 +124,15 @@ std::ostream& operator<<(std::ostream&, const WSDDisambiguationRequest&);
  */
 std::istream& operator>>(std::istream&, WSDDisambiguationRequest&);
 
+/**
+ * Operator for writing to standard streams
+ */
+std::ostream& operator<<(std::ostream&, const WSDDisambiguationBatch&);
+
+/**
+ * Operator for reading from standard streams
+ */
+std::istream& operator>>(std::istream&, WSDDisambiguationBatch&);
+
 
 #endif
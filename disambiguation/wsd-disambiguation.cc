@@ -1,4 +1,9 @@
 #include <iostream>
+#include <fstream>
+#include <deque>
+#include <list>
+#include <sstream>
+#include <atomic>
 
 using namespace std;
 
@@ -15,6 +20,7 @@ using namespace std;
 
 #include "disambiguation.h"
 #include "../graph/rgraph.h"
+#include "../graph/relatedness_table.h"
 #include "../threading/thread.h"
 #include "../communication/connection.h"
 #include "../communication/network.h"
@@ -26,11 +32,19 @@ using namespace std;
 using namespace mico::threading;
 using namespace mico::network;
 using namespace mico::graph;
+using namespace mico::disambiguation::wsd;
 
 void usage(char *cmd) {
   printf("Usage: %s -i fileprefix [-e edges] [-v vertices]\n", cmd);
   printf("Options:\n");
   printf("  -p port          interact through the socket port given as argument\n");
+  printf("  -b               receive batches of requests (DisambiguationBatch) instead of single requests\n");
+  printf("  -l logfile       append all received requests to the log file (for mining frequent pairs with wsd-precompute)\n");
+  printf("  -s seconds       write the relatedness cache to <fileprefix>%s at this interval (default %d, 0 to disable)\n", RELATEDNESS_SUFFIX, RELATEDNESS_SNAPSHOT_INTERVAL);
+  printf("  -t seconds       keep the relatedness values of a session for this time after its last request (default %d)\n", SESSION_TTL);
+  printf("  -r megabytes     memory of the response cache (default %d, 0 to disable)\n", RESPONSE_CACHE_SIZE >> 20);
+  printf("  -d depth         number of requests of a connection disambiguated concurrently (default %d)\n", PIPELINE_DEPTH);
+  printf("  -V               print the statistics of the caches and of the load to standard error after every request\n");
   printf("  -i fileprefix    load the data from the files with the given prefix (e.g. /data/dbpedia)\n");
   printf("  -e edges         hint on the number of edges in the graph (can improve startup performance)\n");
   printf("  -v vertices      hint on the number of vertices in the graph (improve startup performance)\n");
@@ -38,62 +52,391 @@ void usage(char *cmd) {
 }
 
 
-typedef Connection<WSDDisambiguationRequest> connection_t;
+// appends the received requests to a file in the format of the network protocol (length of the
+// message followed by the serialized DisambiguationRequest)
+class request_log {
 
-class worker : public virtual thread {
+  std::ofstream   os;
+  pthread_mutex_t mutex;
 
-  rgraph_complete& graph;
-  connection_t*    connection;
+public:
+
+  request_log(const char* filename) : os(filename, std::ios::out | std::ios::app | std::ios::binary) {
+    pthread_mutex_init(&mutex,NULL);
+  };
+
+  ~request_log() {
+    pthread_mutex_destroy(&mutex);
+  };
+
+  void write(const DisambiguationRequest& r) {
+    std::string data = r.SerializeAsString();
+    uint32_t    hlength = htonl(data.size());
+
+    pthread_mutex_lock(&mutex);
+    os.write((char*)&hlength, sizeof(uint32_t));
+    os.write(data.data(), data.size());
+    os.flush();
+    pthread_mutex_unlock(&mutex);
+  };
+
+  void write(const DisambiguationBatch& b) {
+    for(int i=0; i<b.requests_size(); i++) {
+      write(b.requests(i));
+    }
+  };
+};
+
+
+// bounded queue between two stages of the pipeline of a connection: push blocks while the queue
+// is full, pop blocks while it is empty and returns false once it is closed and empty
+template<class T> class stage_queue {
+
+  std::deque<T>   items;
+  size_t          capacity;
+  bool            closed;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t  not_empty, not_full;
 
 public:
-  
-  worker(connection_t* connection, rgraph_complete& graph) : thread(), connection(connection), graph(graph) {};
-  
 
-  void run() {
-    WSDDisambiguationRequest* req = NULL;
+  stage_queue(size_t capacity) : capacity(capacity), closed(false) {
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&not_empty, NULL);
+    pthread_cond_init(&not_full, NULL);
+  };
 
+  ~stage_queue() {
+    pthread_cond_destroy(&not_full);
+    pthread_cond_destroy(&not_empty);
+    pthread_mutex_destroy(&mutex);
+  };
 
+  void push(const T& item) {
+    pthread_mutex_lock(&mutex);
+    while(items.size() >= capacity) {
+      pthread_cond_wait(&not_full, &mutex);
+    }
+    items.push_back(item);
+    pthread_cond_signal(&not_empty);
+    pthread_mutex_unlock(&mutex);
+  };
 
-    // read requests until finished
-    try {
-      while( (req = connection->nextRequest()) != NULL) {
-	std::cout << "WORKER: received new request\n";
+  bool pop(T& item) {
+    pthread_mutex_lock(&mutex);
+    while(items.empty() && !closed) {
+      pthread_cond_wait(&not_empty, &mutex);
+    }
+    if(items.empty()) {
+      pthread_mutex_unlock(&mutex);
+      return false;
+    }
+    item = items.front();
+    items.pop_front();
+    pthread_cond_signal(&not_full);
+    pthread_mutex_unlock(&mutex);
+    return true;
+  };
+
+  void close() {
+    pthread_mutex_lock(&mutex);
+    closed = true;
+    pthread_cond_broadcast(&not_empty);
+    pthread_mutex_unlock(&mutex);
+  };
+};
+
+
+// R is the type of messages received over the connection (WSDDisambiguationRequest or
+// WSDDisambiguationBatch). The requests of a connection pass through a pipeline of stages, each
+// with its own threads and connected by bounded queues:
+//   - parse: the worker thread reads and parses the requests from the connection
+//   - disambiguation: depth threads resolve the candidates, compute the relatedness (in the shared
+//     relatedness thread pool) and the centrality, so that the centrality of a request overlaps
+//     with the relatedness of the next ones
+//   - serialize: a writer thread sends the responses in the order the requests were received
+// When the queues are full, the worker stops reading from the connection.
+template<class R> class worker : public virtual thread {
 
+  typedef Connection<R> connection_t;
+
+  // a request passing through the pipeline
+  struct job {
+    R*   req;
+    bool done;   // disambiguation finished (guarded by the mutex of the worker)
+
+    job(R* req) : req(req), done(false) {};
+  };
+
+  // thread running one of the stages of the worker
+  class stage : public virtual thread {
+    worker& w;
+    void (worker::*method)();
+
+  public:
+    stage(worker& w, void (worker::*method)()) : thread(), w(w), method(method) {};
+
+    void run() {
+      (w.*method)();
+    };
+  };
+
+  rgraph_complete&        graph;
+  relatedness_threadpool& pool;
+  const services&         srv;
+  request_log*            log;
+  connection_t*           connection;
+  int                     depth;
+  bool                    verbose;     // print statistics after every request
+
+  stage_queue<job*>       requests;    // parsed requests waiting for disambiguation
+  stage_queue<job*>       responses;   // all requests in progress, in the order received
+
+  pthread_mutex_t         mutex;
+  pthread_cond_t          finished;    // signalled when a job is done
+  std::atomic<bool>       failed;      // the connection cannot be written any more
+  std::atomic<bool>       closed;      // all requests are done and the connection is closed
+
+
+  // print the statistics of the server-wide caches and of the load controller
+  void statistics() {
+    std::ostringstream out;
+
+    out << "WORKER: relatedness cache " << pool.get_cache().hits() << " hits, " << pool.get_cache().misses() << " misses, "
+	<< pool.get_cache().evictions() << " evictions, " << pool.get_flights().coalesced() << " coalesced, "
+	<< pool.get_flights().merged() << " merged\n";
+    if(srv.sessions != NULL) {
+      out << "WORKER: " << srv.sessions->size() << " sessions, " << srv.sessions->reused() << " values reused\n";
+    }
+    if(srv.responses != NULL) {
+      out << "WORKER: response cache " << srv.responses->hits() << " hits, " << srv.responses->misses() << " misses, "
+	  << srv.responses->evictions() << " evictions\n";
+    }
+    if(srv.load != NULL) {
+      out << "WORKER: load " << srv.load->requests() << " requests in progress, " << srv.load->degraded() << " degraded, "
+	  << srv.load->rejected() << " rejected\n";
+    }
+    std::cerr << out.str();
+  };
+
+
+  // disambiguation stage
+  void disambiguate() {
+    job* j;
+
+    while(requests.pop(j)) {
 #ifdef HAVE_TIMER_H
-	boost::timer::auto_cpu_timer* timer = new boost::timer::auto_cpu_timer("WORKER: %w wall, %u user + %s system = %t (%p% CPU)\n");
+      boost::timer::auto_cpu_timer* timer = new boost::timer::auto_cpu_timer("WORKER: %w wall, %u user + %s system = %t (%p% CPU)\n");
 #endif
-	req->disambiguation(&graph);
+      j->req->disambiguation(&graph, &pool, srv);
 #ifdef HAVE_TIMER_H
-	delete timer;
+      delete timer;
 #endif
+      if(verbose) {
+	statistics();
+      }
+
+      pthread_mutex_lock(&mutex);
+      j->done = true;
+      pthread_cond_broadcast(&finished);
+      pthread_mutex_unlock(&mutex);
+    }
+  };
+
+
+  // serialization stage; after an error on the connection, the remaining responses are dropped
+  void serialize() {
+    job* j;
 
-	*connection << *req;
-	delete req;
-	req = NULL;
+    while(responses.pop(j)) {
+      pthread_mutex_lock(&mutex);
+      while(!j->done) {
+	pthread_cond_wait(&finished, &mutex);
       }
-    } catch(std::ios_base::failure) {
-      std::cerr << "error writing response to network connection\n";
-      if(req != NULL) {
-	delete req;
+      pthread_mutex_unlock(&mutex);
+
+      if(!failed) {
+	try {
+	  *connection << *j->req;
+	} catch(const std::ios_base::failure&) {
+	  std::cerr << "error writing response to network connection\n";
+	  failed = true;
+	}
       }
+      delete j->req;
+      delete j;
     }
+  };
+
+public:
+  
+  worker(connection_t* connection, rgraph_complete& graph, relatedness_threadpool& pool, const services& srv, request_log* log, int depth, bool verbose)
+    : thread(), graph(graph), pool(pool), srv(srv), log(log), connection(connection), depth(depth), verbose(verbose),
+      requests(PIPELINE_QUEUE), responses(PIPELINE_QUEUE + depth), failed(false), closed(false) {
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&finished, NULL);
+  };
+
+  ~worker() {
+    pthread_cond_destroy(&finished);
+    pthread_mutex_destroy(&mutex);
+  };
 
+
+  // parse stage
+  void run() {
+    R* req = NULL;
+    std::vector<stage*> stages;
+
+    for(int i=0; i<depth; i++) {
+      stages.push_back(new stage(*this, &worker::disambiguate));
+    }
+    stages.push_back(new stage(*this, &worker::serialize));
+    for(size_t i=0; i<stages.size(); i++) {
+      stages[i]->start();
+    }
+
+    // read requests until finished
+    try {
+      while(!failed && (req = connection->nextRequest()) != NULL) {
+	std::cout << "WORKER: received new request\n";
+
+	if(log != NULL) {
+	  log->write(*req);
+	}
+
+	// responses first, so the writer sees the jobs in the order received
+	job* j = new job(req);
+	responses.push(j);
+	requests.push(j);
+      }
+    } catch(const std::ios_base::failure&) {
+      std::cerr << "error reading request from network connection\n";
+    }
+
+    // let the stages finish the requests received so far
+    requests.close();
+    for(int i=0; i<depth; i++) {
+      stages[i]->join();
+    }
+    responses.close();
+    stages[depth]->join();
+
+    for(size_t i=0; i<stages.size(); i++) {
+      delete stages[i];
+    }
     delete connection;
+    closed = true;
+  };
+
+  /**
+   * The worker is done with its connection; it only remains to be joined and deleted.
+   */
+  inline bool is_closed() const { return closed; };
+
+};
+
+
+// periodically write the relatedness cache of the pool to the relatedness file of the graph, so
+// that a restarted server can start with the values; the values of the table mapped from the file
+// (e.g. precomputed by wsd-precompute) are kept
+class snapshot_writer : public virtual thread {
+
+  relatedness_threadpool& pool;
+  std::string             filename;
+  uint64_t                fingerprint;
+  int                     interval;
+  size_t                  max;         // number of records written at most
+
+public:
+
+  snapshot_writer(relatedness_threadpool& pool, const char* filename, uint64_t fingerprint, int interval, const relatedness_table* table)
+    : thread(), pool(pool), filename(filename), fingerprint(fingerprint), interval(interval),
+      max(RELATEDNESS_CACHE_ENTRIES + (table != NULL ? table->size : 0)) {};
+
+  void snapshot() {
+    std::vector<relatedness_table::record> records;
+
+    pool.get_cache().snapshot(records, max);
+    relatedness_table::dump_file(filename.c_str(), fingerprint, records);
+  };
+
+  void run() {
+    int state;
+
+    // only cancelled while sleeping, never in the middle of writing a snapshot
+    while(true) {
+      sleep(interval);
+      pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &state);
+      snapshot();
+      pthread_setcancelstate(state, NULL);
+    }
   };
 
 };
 
 
+// accept connections on the port (or use standard input/output if port is 0) and process the
+// messages of type R received over them
+template<class R> void serve(int port, rgraph_complete& graph, relatedness_threadpool& pool, const services& srv, request_log* log, int depth, bool verbose) {
+  // open socket if -p is specified on command line
+  if(port) {
+    Socket<R> socket(port);
+    Connection<R>* conn;
+    std::list<worker<R>*> workers;
+#ifndef PROFILING
+    while( (conn = socket.accept()) != NULL) {
+#else
+      if( (conn = socket.accept()) != NULL) {
+#endif
+      // clean up the workers of connections closed in the meantime
+      for(typename std::list<worker<R>*>::iterator it = workers.begin(); it != workers.end(); ) {
+	if((*it)->is_closed()) {
+	  (*it)->join();
+	  delete *it;
+	  it = workers.erase(it);
+	} else {
+	  ++it;
+	}
+      }
+
+      worker<R>* w = new worker<R>(conn, graph, pool, srv, log, depth, verbose);
+      w->start();
+      workers.push_back(w);
+    }
+
+    // wait for the connections still open
+    for(typename std::list<worker<R>*>::iterator it = workers.begin(); it != workers.end(); ++it) {
+      (*it)->join();
+      delete *it;
+    }
+
+  } else {
+      worker<R>* w = new worker<R>(new Connection<R>(), graph, pool, srv, log, depth, verbose);
+      w->start();
+      w->join();
+      delete w;
+  }
+}
+
+
 int main(int argc, char** argv) {
   int opt;
   char *ifile = NULL;
   int port = 0;
+  bool batch = false;
+  int snapshot_interval = RELATEDNESS_SNAPSHOT_INTERVAL;
+  char *logfile = NULL;
+  int session_ttl = SESSION_TTL;
+  long int response_mb = RESPONSE_CACHE_SIZE >> 20;
+  int depth = PIPELINE_DEPTH;
+  bool verbose = false;
   long int reserve_edges = 1<<16;
   long int reserve_vertices = 1<<12;
 
   // read options from command line
-  while( (opt = getopt(argc,argv,"i:p:")) != -1) {
+  while( (opt = getopt(argc,argv,"i:p:bs:l:t:r:d:V")) != -1) {
     switch(opt) {
     case 'i':
       ifile = optarg;
@@ -101,6 +444,27 @@ int main(int argc, char** argv) {
     case 'p':
       port = atoi(optarg);
       break;
+    case 'b':
+      batch = true;
+      break;
+    case 's':
+      snapshot_interval = atoi(optarg);
+      break;
+    case 'l':
+      logfile = optarg;
+      break;
+    case 't':
+      session_ttl = atoi(optarg);
+      break;
+    case 'r':
+      response_mb = atol(optarg) > 0 ? atol(optarg) : 0;
+      break;
+    case 'd':
+      depth = atoi(optarg) > 0 ? atoi(optarg) : 1;
+      break;
+    case 'V':
+      verbose = true;
+      break;
     default:
       usage(argv[0]);
     }
@@ -113,27 +477,48 @@ int main(int argc, char** argv) {
     // first restore existing dump in case -i is given
     graph.restore_file(ifile);
 
-    // open socket if -p is specified on command line
-    if(port) {
-      Socket<WSDDisambiguationRequest> socket(port);
-      Connection<WSDDisambiguationRequest>* conn;
-#ifndef PROFILING
-      while( (conn = socket.accept()) != NULL) {
-#else
-	if( (conn = socket.accept()) != NULL) {
-#endif
-	worker* w = new worker(conn, graph);
-	w->start();
-#ifdef PROFILING
-	w->join();
-#endif    
-      }
+    // relatedness workers shared by all connections
+    relatedness_threadpool pool(&graph);
 
+    // server-wide state of the requests besides the relatedness workers
+    services          srv;
+    session_store     sessions(session_ttl, SESSION_MAX);
+    response_cache    responses((size_t)response_mb << 20);
+    relatedness_costs costs(&graph);
+    load_controller   load;
+    srv.sessions  = &sessions;
+    srv.responses = responses.enabled() ? &responses : NULL;
+    srv.costs     = &costs;
+    srv.load      = &load;
+
+    // start with the relatedness values precomputed or cached by a previous run on the same graph
+    std::string rfile = std::string(ifile) + RELATEDNESS_SUFFIX;
+    uint64_t    fingerprint = graph.fingerprint();
+    relatedness_table* table = relatedness_table::map_file(rfile.c_str(), fingerprint);
+    pool.attach(table);
+
+    snapshot_writer snapshots(pool, rfile.c_str(), fingerprint, snapshot_interval, table);
+    if(snapshot_interval > 0) {
+      snapshots.start();
+    }
+
+    request_log* log = logfile != NULL ? new request_log(logfile) : NULL;
+
+    if(batch) {
+      serve<WSDDisambiguationBatch>(port, graph, pool, srv, log, depth, verbose);
     } else {
-	worker* w = new worker(new Connection<WSDDisambiguationRequest>(), graph);
-	w->start();
-	w->join();
+      serve<WSDDisambiguationRequest>(port, graph, pool, srv, log, depth, verbose);
+    }
+
+    delete log;
+
+    if(snapshot_interval > 0) {
+      snapshots.cancel();
+      snapshots.join();
+      snapshots.snapshot();
     }
+    pool.attach(NULL);
+    delete table;
 
     
     google::protobuf::ShutdownProtobufLibrary();
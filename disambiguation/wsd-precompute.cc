@@ -0,0 +1,194 @@
+/*
+ * Offline relatedness precomputation. Reads logs of disambiguation requests (as written by
+ * wsd-disambiguation -l), counts how often each pair of candidates occurs within the maxdist
+ * window of a SHORTEST_PATH or DFS request, and computes the relatedness of the most frequent pairs
+ * in the relatedness thread pool. The values are written to the relatedness file next to the graph
+ * dump, which the disambiguation server maps on startup, so that the expensive computations for
+ * the head of the distribution no longer happen while answering requests.
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "disambiguation.h"
+#include "../graph/rgraph.h"
+#include "../graph/relatedness_table.h"
+#include "../communication/connection.h"
+
+using namespace mico::network;
+using namespace mico::graph;
+using namespace mico::disambiguation::wsd;
+
+
+void usage(char *cmd) {
+  printf("Usage: %s -i fileprefix [-o outfile] [-n pairs] [-m count] logfiles...\n", cmd);
+  printf("Options:\n");
+  printf("  -i fileprefix    load the graph from the files with the given prefix (e.g. /data/dbpedia)\n");
+  printf("  -o outfile       write the relatedness values to this file (default <fileprefix>%s)\n", RELATEDNESS_SUFFIX);
+  printf("  -n pairs         number of most frequent pairs to compute (default %d)\n", RELATEDNESS_CACHE_ENTRIES);
+  printf("  -m count         only compute pairs occurring in at least this number of requests (default 2)\n");
+  exit(1);
+}
+
+
+// a pair of candidates seen in the logs, with the algorithm configuration it was requested with
+struct candidate_pair {
+  long     count;
+  int      algorithm;
+  int      max_dist;
+  uint64_t pair;
+
+  // most frequent first
+  inline bool operator<(const candidate_pair& o) const { return count > o.count; };
+};
+
+
+int main(int argc, char** argv) {
+  int opt, k;
+  char *ifile = NULL, *ofile = NULL;
+  long max_pairs = RELATEDNESS_CACHE_ENTRIES;
+  long min_count = 2;
+
+  // read options from command line
+  while( (opt = getopt(argc,argv,"i:o:n:m:")) != -1) {
+    switch(opt) {
+    case 'i':
+      ifile = optarg;
+      break;
+    case 'o':
+      ofile = optarg;
+      break;
+    case 'n':
+      max_pairs = atol(optarg);
+      break;
+    case 'm':
+      min_count = atol(optarg);
+      break;
+    default:
+      usage(argv[0]);
+    }
+  }
+
+  if(ifile == NULL || optind >= argc) {
+    usage(argv[0]);
+  }
+
+  rgraph_complete graph;
+  graph.restore_file(ifile);
+
+  std::string rfile = ofile != NULL ? std::string(ofile) : std::string(ifile) + RELATEDNESS_SUFFIX;
+
+  // 1. count the pairs of all requests per algorithm configuration; pairs occurring several times
+  // in the same request count once
+  typedef std::pair<int,int> configuration; // algorithm, maxdist
+  std::map<configuration, std::unordered_map<uint64_t, long> > counts;
+  long num_requests = 0;
+
+  for(; optind < argc; optind++) {
+    int fd = open(argv[optind], O_RDONLY);
+    if(fd < 0) {
+      std::cerr << "could not read request log " << argv[optind] << "\n";
+      continue;
+    }
+
+    std::cout << "reading requests from " << argv[optind] << " ...\n";
+
+    Connection<WSDDisambiguationRequest> log(fd);
+    WSDDisambiguationRequest* req;
+    while( (req = log.nextRequest()) != NULL) {
+      num_requests++;
+
+      if(req->relatedness() == DisambiguationRequest::SHORTEST_PATH || req->relatedness() == DisambiguationRequest::DFS) {
+	relatedness_batch pairs(req->relatedness(), req->maxdist(), DBL_MAX);
+	req->add_pairs(&graph, pairs);
+
+	std::unordered_map<uint64_t, long>& c = counts[configuration(req->relatedness(), req->maxdist())];
+	for(size_t t = 0; t < pairs.size(); t++) {
+	  c[relatedness_table::pair(pairs.get_task(t).from, pairs.get_task(t).to)]++;
+	}
+      }
+      delete req;
+    }
+  }
+
+  // 2. select the most frequent pairs
+  std::vector<candidate_pair> selected;
+  for(std::map<configuration, std::unordered_map<uint64_t, long> >::iterator it = counts.begin(); it != counts.end(); ++it) {
+    for(std::unordered_map<uint64_t, long>::iterator p = it->second.begin(); p != it->second.end(); ++p) {
+      if(p->second >= min_count) {
+	candidate_pair c = { p->second, it->first.first, it->first.second, p->first };
+	selected.push_back(c);
+      }
+    }
+    it->second.clear();
+  }
+  if((long)selected.size() > max_pairs) {
+    std::nth_element(selected.begin(), selected.begin() + max_pairs, selected.end());
+    selected.resize(max_pairs);
+  }
+
+  std::cout << "found " << selected.size() << " frequent candidate pairs in " << num_requests << " requests\n";
+
+  // 3. compute their relatedness in the thread pool, one batch per configuration, without cutoff so
+  // that the values can be used by requests with any cutoff
+  std::map<configuration, relatedness_batch*> batches;
+  for(size_t i = 0; i < selected.size(); i++) {
+    configuration c(selected[i].algorithm, selected[i].max_dist);
+    relatedness_batch*& b = batches[c];
+    if(b == NULL) {
+      b = new relatedness_batch((DisambiguationRequest::RelatednessAlgorithm)c.first, c.second, DBL_MAX);
+    }
+    b->add_pair((int)(selected[i].pair >> 32), (int)(uint32_t)selected[i].pair);
+  }
+
+  std::vector<relatedness_table::record> records;
+  relatedness_table::record r;
+  r.reserved = 0;
+  r.cutoff   = DBL_MAX;
+  {
+    relatedness_threadpool pool(&graph);
+
+    for(std::map<configuration, relatedness_batch*>::iterator it = batches.begin(); it != batches.end(); ++it) {
+      std::cout << "computing " << it->second->size() << " relatedness values (algorithm " << it->first.first << ", maxdist " << it->first.second << ") ...\n";
+      pool.execute(*it->second);
+
+      r.config = relatedness_table::config(it->first.first, it->first.second);
+      for(size_t t = 0; t < it->second->size(); t++) {
+	const rtask& task = it->second->get_task(t);
+	r.pair        = relatedness_table::pair(task.from, task.to);
+	r.relatedness = task.relatedness;
+	records.push_back(r);
+      }
+      delete it->second;
+    }
+  }
+
+  // 4. keep the values of an existing file for the same graph that were not recomputed
+  uint64_t fingerprint = graph.fingerprint();
+  relatedness_table* existing = relatedness_table::map_file(rfile.c_str(), fingerprint);
+  if(existing != NULL) {
+    std::sort(records.begin(), records.end());
+    size_t computed = records.size();
+    for(long j = 0; j < existing->size; j++) {
+      if(!std::binary_search(records.begin(), records.begin() + computed, existing->records[j])) {
+	records.push_back(existing->records[j]);
+      }
+    }
+  }
+
+  k = relatedness_table::dump_file(rfile.c_str(), fingerprint, records) ? 0 : 1;
+  delete existing;
+
+  google::protobuf::ShutdownProtobufLibrary();
+
+  return k;
+}
@@ -0,0 +1,391 @@
+#include <math.h>
+#include <float.h>
+#include <string.h>
+
+#include <queue>
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "wsd_centrality.h"
+#include "wsd_relatedness_worker.h"
+#include "../config.h"
+
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      // sum of a[i] * b[i]; if b is NULL, the sum of a[i]
+      static inline double dot(const double* a, const double* b, long n) {
+	long   i = 0;
+	double sum;
+
+#if defined(__AVX2__)
+	__m256d acc = _mm256_setzero_pd();
+	for(; i + 4 <= n; i += 4) {
+	  __m256d va = _mm256_loadu_pd(a + i);
+	  acc = _mm256_add_pd(acc, b == NULL ? va : _mm256_mul_pd(va, _mm256_loadu_pd(b + i)));
+	}
+	__m128d s = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+	sum = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+#elif defined(__SSE2__)
+	__m128d acc = _mm_setzero_pd();
+	for(; i + 2 <= n; i += 2) {
+	  __m128d va = _mm_loadu_pd(a + i);
+	  acc = _mm_add_pd(acc, b == NULL ? va : _mm_mul_pd(va, _mm_loadu_pd(b + i)));
+	}
+	sum = _mm_cvtsd_f64(_mm_add_sd(acc, _mm_unpackhi_pd(acc, acc)));
+#else
+	sum = 0.0;
+#endif
+
+	for(; i < n; i++) {
+	  sum += b == NULL ? a[i] : a[i] * b[i];
+	}
+	return sum;
+      }
+
+
+      centrality_graph::centrality_graph(const igraph_t* graph, const igraph_vector_t* w)
+	: n(igraph_vcount(graph)), dense(NULL) {
+	long m = igraph_ecount(graph);
+	long e, k;
+	int  u, v;
+
+	// count the neighbours of every vertice, then fill both directions of every edge
+	offsets.assign(n + 1, 0);
+	for(e = 0; e < m; e++) {
+	  offsets[(long int)VECTOR(graph->from)[e] + 1]++;
+	  offsets[(long int)VECTOR(graph->to)[e] + 1]++;
+	}
+	for(u = 0; u < n; u++) {
+	  offsets[u + 1] += offsets[u];
+	}
+
+	std::vector<long> pos(offsets.begin(), offsets.end() - 1);
+	targets.resize(2 * m);
+	weights.resize(2 * m);
+	for(e = 0; e < m; e++) {
+	  u = (int)VECTOR(graph->from)[e];
+	  v = (int)VECTOR(graph->to)[e];
+
+	  k = pos[u]++;
+	  targets[k] = v;
+	  weights[k] = VECTOR(*w)[e];
+
+	  k = pos[v]++;
+	  targets[k] = u;
+	  weights[k] = VECTOR(*w)[e];
+	}
+
+	// neighbours in order of their id, so that sums over a row (and thus the results) do not
+	// depend on the order the edges were added to the graph in
+	std::vector<std::pair<int,double> > row;
+	for(u = 0; u < n; u++) {
+	  row.clear();
+	  for(k = offsets[u]; k < offsets[u + 1]; k++) {
+	    row.push_back(std::make_pair(targets[k], weights[k]));
+	  }
+	  std::sort(row.begin(), row.end());
+	  for(k = offsets[u]; k < offsets[u + 1]; k++) {
+	    targets[k] = row[k - offsets[u]].first;
+	    weights[k] = row[k - offsets[u]].second;
+	  }
+	}
+
+	if(n <= CENTRALITY_DENSE_MAX) {
+	  dense = new double[(long int)n * n];
+	  memset(dense, 0, (long int)n * n * sizeof(double));
+	  for(u = 0; u < n; u++) {
+	    for(k = offsets[u]; k < offsets[u + 1]; k++) {
+	      dense[(long int)u * n + targets[k]] += weights[k];
+	    }
+	  }
+	}
+
+	// weighted degree: sum of the (contiguous) weights of a row
+	strength.resize(n);
+	for(u = 0; u < n; u++) {
+	  strength[u] = dot(weights.data() + offsets[u], NULL, offsets[u + 1] - offsets[u]);
+	}
+      }
+
+      centrality_graph::~centrality_graph() {
+	delete[] dense;
+      }
+
+
+      void centrality_graph::multiply(const double* x, double* y) const {
+	int  v;
+	long k;
+
+	if(dense != NULL) {
+	  for(v = 0; v < n; v++) {
+	    y[v] = dot(dense + (long int)v * n, x, n);
+	  }
+	} else {
+	  for(v = 0; v < n; v++) {
+	    double sum = 0.0;
+	    for(k = offsets[v]; k < offsets[v + 1]; k++) {
+	      sum += weights[k] * x[targets[k]];
+	    }
+	    y[v] = sum;
+	  }
+	}
+      }
+
+
+      void centrality_graph::degree(double* out) const {
+	memcpy(out, strength.data(), n * sizeof(double));
+      }
+
+
+      void centrality_graph::pagerank(double damping, double* out) const {
+	std::vector<double> x(n, 1.0 / n), z(n), y(n);
+	double dangling, total, diff;
+	int    v, it;
+
+	for(it = 0; it < CENTRALITY_MAX_ITERATIONS; it++) {
+
+	  // rank each vertice passes on per unit of edge weight; vertices without edges pass their
+	  // rank on to all vertices
+	  dangling = 0.0;
+	  for(v = 0; v < n; v++) {
+	    if(strength[v] > 0.0) {
+	      z[v] = x[v] / strength[v];
+	    } else {
+	      z[v] = 0.0;
+	      dangling += x[v];
+	    }
+	  }
+
+	  multiply(&z[0], &y[0]);
+
+	  total = 0.0;
+	  for(v = 0; v < n; v++) {
+	    y[v]   = (1.0 - damping + damping * dangling) / n + damping * y[v];
+	    total += y[v];
+	  }
+
+	  diff = 0.0;
+	  for(v = 0; v < n; v++) {
+	    y[v] /= total;
+	    diff += fabs(y[v] - x[v]);
+	  }
+
+	  x.swap(y);
+	  if(diff < CENTRALITY_EPSILON) {
+	    break;
+	  }
+	}
+
+	memcpy(out, x.data(), n * sizeof(double));
+      }
+
+
+      void centrality_graph::eigenvector(double* out) const {
+	std::vector<double> x(strength), y(n);
+	double max, diff;
+	int    v, it;
+
+	// start with the degrees, like igraph
+	max = 0.0;
+	for(v = 0; v < n; v++) {
+	  max = x[v] > max ? x[v] : max;
+	}
+	if(max <= 0.0) {
+	  for(v = 0; v < n; v++) {
+	    out[v] = 1.0;
+	  }
+	  return;
+	}
+
+	for(v = 0; v < n; v++) {
+	  x[v] /= max;
+	}
+
+	// power iteration with A + I: same eigenvectors as A, but the dominant eigenvalue stays
+	// dominant in magnitude, so the iteration also converges on (nearly) bipartite graphs
+	for(it = 0; it < CENTRALITY_MAX_ITERATIONS; it++) {
+	  multiply(&x[0], &y[0]);
+
+	  max = 0.0;
+	  for(v = 0; v < n; v++) {
+	    y[v] += x[v];
+	    max   = y[v] > max ? y[v] : max;
+	  }
+
+	  diff = 0.0;
+	  for(v = 0; v < n; v++) {
+	    y[v] /= max;
+	    diff += fabs(y[v] - x[v]);
+	  }
+
+	  x.swap(y);
+	  if(diff < CENTRALITY_EPSILON) {
+	    break;
+	  }
+	}
+
+	memcpy(out, x.data(), n * sizeof(double));
+      }
+
+
+      /**
+       * One shortest path search per source vertice, computed in the thread pool. Every worker
+       * keeps its own search state. Betweenness contributions are summed up per block of
+       * consecutive sources (the tasks of the batch), so the result does not depend on which
+       * worker searched from which source.
+       */
+      class source_batch : public pool_batch {
+
+	// search state of a worker
+	struct search {
+	  std::vector<double> dist, sigma, delta;
+	  std::vector<int>    settled;   // position in order + 1, 0 if not (yet) settled
+	  std::vector<int>    order;     // vertices in the order they were settled
+	  std::priority_queue<std::pair<double,int>, std::vector<std::pair<double,int> >, std::greater<std::pair<double,int> > > queue;
+	};
+
+	const centrality_graph& g;
+	bool                    brandes;  // betweenness (true) or closeness (false)
+
+      public:
+	search                  states[NUM_THREADS];
+	std::vector<double>     closeness;                // closeness of every source
+	std::vector<std::vector<double> > betweenness;    // betweenness contributions of every block
+
+	source_batch(const centrality_graph& g, bool brandes)
+	  : g(g), brandes(brandes), closeness(brandes ? 0 : g.n),
+	    betweenness(brandes ? (g.n < CENTRALITY_BLOCKS ? g.n : CENTRALITY_BLOCKS) : 0) {};
+
+	inline size_t size() const { return brandes ? betweenness.size() : g.n; };
+
+	void compute(relatedness_worker& worker, size_t first, size_t last);
+
+      private:
+	void dijkstra(search& st, int source) const;
+      };
+
+
+      // Dijkstra from the source, counting the number of shortest paths to each vertice
+      void source_batch::dijkstra(search& st, int source) const {
+	long   k;
+	int    u, v;
+	double d, alt;
+
+	st.dist.assign(g.n, DBL_MAX);
+	st.sigma.assign(g.n, 0.0);
+	st.settled.assign(g.n, 0);
+	st.order.clear();
+
+	st.dist[source]  = 0.0;
+	st.sigma[source] = 1.0;
+	st.queue.push(std::make_pair(0.0, source));
+
+	while(!st.queue.empty()) {
+	  d = st.queue.top().first;
+	  u = st.queue.top().second;
+	  st.queue.pop();
+
+	  if(st.settled[u]) {
+	    continue;
+	  }
+	  st.order.push_back(u);
+	  st.settled[u] = st.order.size();
+
+	  for(k = g.offsets[u]; k < g.offsets[u + 1]; k++) {
+	    v   = g.targets[k];
+	    alt = d + g.weights[k];
+
+	    if(st.settled[v]) {
+	      continue;
+	    }
+	    if(alt < st.dist[v]) {
+	      st.dist[v]  = alt;
+	      st.sigma[v] = st.sigma[u];
+	      st.queue.push(std::make_pair(alt, v));
+	    } else if(alt == st.dist[v]) {
+	      st.sigma[v] += st.sigma[u];
+	    }
+	  }
+	}
+      }
+
+
+      void source_batch::compute(relatedness_worker& worker, size_t first, size_t last) {
+	search& st = states[worker.get_id()];
+	size_t  s, b, blocks = betweenness.size();
+	long    i, k;
+	int     v, w;
+	double  sum;
+
+	if(!brandes) {
+	  for(s = first; s < last; s++) {
+	    dijkstra(st, s);
+
+	    sum = 0.0;
+	    for(i = 1; i < (long)st.order.size(); i++) {
+	      sum += st.dist[st.order[i]];
+	    }
+	    sum += (double)(g.n - (long)st.order.size()) * g.n;
+	    closeness[s] = sum > 0.0 ? (g.n - 1) / sum : 0.0;
+	  }
+	  return;
+	}
+
+	for(b = first; b < last; b++) {
+	  std::vector<double>& acc = betweenness[b];
+	  acc.assign(g.n, 0.0);
+
+	  for(s = b * g.n / blocks; s < (b + 1) * g.n / blocks; s++) {
+	    dijkstra(st, s);
+
+	    // accumulate dependencies in reverse order of distance; the predecessors of a vertice
+	    // are the neighbours settled before it whose distance plus the edge weight gives its
+	    // distance
+	    st.delta.assign(g.n, 0.0);
+	    for(i = (long)st.order.size() - 1; i > 0; i--) {
+	      w = st.order[i];
+	      for(k = g.offsets[w]; k < g.offsets[w + 1]; k++) {
+		v = g.targets[k];
+		if(st.settled[v] && st.settled[v] < st.settled[w] && st.dist[v] + g.weights[k] == st.dist[w]) {
+		  st.delta[v] += st.sigma[v] / st.sigma[w] * (1.0 + st.delta[w]);
+		}
+	      }
+	      acc[w] += st.delta[w];
+	    }
+	  }
+	}
+      }
+
+
+      void centrality_graph::betweenness(relatedness_threadpool* pool, double* out) const {
+	source_batch batch(*this, true);
+	int i, v;
+
+	pool->execute(batch);
+
+	// add up the blocks in order; every path of the undirected graph was counted from both ends
+	memset(out, 0, n * sizeof(double));
+	for(i = 0; i < (int)batch.betweenness.size(); i++) {
+	  for(v = 0; v < n; v++) {
+	    out[v] += batch.betweenness[i][v] / 2.0;
+	  }
+	}
+      }
+
+
+      void centrality_graph::closeness(relatedness_threadpool* pool, double* out) const {
+	source_batch batch(*this, false);
+
+	pool->execute(batch);
+
+	memcpy(out, batch.closeness.data(), n * sizeof(double));
+      }
+
+    }
+  }
+}
@@ -0,0 +1,107 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_WSD_CENTRALITY_H
+#define HAVE_WSD_CENTRALITY_H 1
+
+#include <vector>
+#include <igraph/igraph.h>
+
+/**
+ * Centrality computations specialised for the small disambiguation graphs (a few hundred
+ * vertices). The general igraph routines solve the eigenvector and PageRank problems with ARPACK,
+ * whose setup cost dominates at this size; here they are computed by plain power iteration over
+ * an adjacency matrix held in cache.
+ *
+ * The graph is treated as undirected (as in the igraph calls it replaces), and the relatedness
+ * values are used as edge weights. The adjacency is kept as a symmetric CSR structure and, for
+ * graphs of up to CENTRALITY_DENSE_MAX vertices, additionally as a dense row-major matrix, so that
+ * the matrix-vector products of the power iteration run over contiguous rows with SIMD
+ * instructions.
+ *
+ * Betweenness and closeness centrality need one shortest path search per vertice (Brandes'
+ * algorithm resp. Dijkstra). These searches are independent and run in the worker threads of the
+ * relatedness thread pool; betweenness contributions are summed up per block of sources, and the
+ * blocks are added up in order once all searches are done.
+ *
+ * All results are deterministic: the neighbours of a vertice are sorted by id and sums never
+ * depend on the order of the edges or on the scheduling of the searches, so the same graph
+ * always gives the same centralities (required for caching whole responses).
+ *
+ * Usage:
+ *   centrality_graph c(&wsd_graph, &wsd_weights);
+ *
+ *   igraph_vector_resize(&wsd_centralities, c.size());
+ *   c.pagerank(0.85, VECTOR(wsd_centralities));
+ */
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      class relatedness_threadpool;
+
+      class centrality_graph {
+
+	friend class source_batch;
+
+	int n;
+
+	// symmetric adjacency in CSR format: the neighbours of v are targets[offsets[v]..offsets[v+1])
+	std::vector<long>   offsets;
+	std::vector<int>    targets;
+	std::vector<double> weights;
+
+	// dense row-major adjacency (NULL if the graph is too large)
+	double* dense;
+
+	// weighted degree (strength) of every vertice
+	std::vector<double> strength;
+
+	// y = A x
+	void multiply(const double* x, double* y) const;
+
+      public:
+
+	/**
+	 * Build the adjacency of the given graph with the given edge weights.
+	 */
+	centrality_graph(const igraph_t* graph, const igraph_vector_t* weights);
+
+	~centrality_graph();
+
+	inline int size() const { return n; };
+
+	/**
+	 * Weighted degree of every vertice.
+	 */
+	void degree(double* out) const;
+
+	/**
+	 * PageRank with the given damping factor; the random walk follows an edge with probability
+	 * proportional to its weight, vertices without edges jump to all vertices. The result sums
+	 * up to 1.
+	 */
+	void pagerank(double damping, double* out) const;
+
+	/**
+	 * Eigenvector centrality, scaled to a maximum of 1. Graphs without (weighted) edges get a
+	 * centrality of 1 for all vertices.
+	 */
+	void eigenvector(double* out) const;
+
+	/**
+	 * Betweenness centrality (weights are path lengths), computed in the threads of the pool.
+	 */
+	void betweenness(relatedness_threadpool* pool, double* out) const;
+
+	/**
+	 * Closeness centrality (weights are path lengths), computed in the threads of the pool.
+	 * Vertices that cannot be reached count with a distance of the number of vertices, like in
+	 * igraph.
+	 */
+	void closeness(relatedness_threadpool* pool, double* out) const;
+      };
+
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,37 @@
+#include "wsd_load.h"
+#include "../config.h"
+
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      load_controller::load_controller() : active(0), num_degraded(0), num_rejected(0) {
+      }
+
+
+      load_controller::level load_controller::admit(size_t backlog) {
+	int n = active.fetch_add(1) + 1;
+
+	if(n > LOAD_REJECT) {
+	  num_rejected.fetch_add(1, std::memory_order_relaxed);
+	  return REJECTED;
+	}
+	if(backlog >= LOAD_MINIMAL) {
+	  num_degraded.fetch_add(1, std::memory_order_relaxed);
+	  return MINIMAL;
+	}
+	if(backlog >= LOAD_DEGRADE) {
+	  num_degraded.fetch_add(1, std::memory_order_relaxed);
+	  return DEGRADED;
+	}
+	return NORMAL;
+      }
+
+
+      void load_controller::leave() {
+	active.fetch_sub(1);
+      }
+
+    }
+  }
+}
@@ -0,0 +1,65 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_LOAD_H
+#define HAVE_LOAD_H 1
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Load-aware degradation of the disambiguation server. All connections share the workers of the
+ * relatedness thread pool; when more relatedness work arrives than the workers can handle, the
+ * batches of all requests wait in the queue and every request gets slow. Instead, the controller
+ * admits each request at a level of degradation, depending on the number of batches waiting for
+ * the workers (the queue depth; batches only wait while all workers are busy) and the number of
+ * requests in progress:
+ *   - NORMAL:   the request is computed as requested
+ *   - DEGRADED: expensive relatedness algorithms are replaced by cheaper ones (SHORTEST_PATH by
+ *               DFS, DFS, JACCARD and ADAMIC_ADAR by PARTITION, CASCADE by its filter algorithm,
+ *               AUTO gets a quarter of its budget); from LOAD_DEGRADE waiting batches on
+ *   - MINIMAL:  all requests use constant time relatedness with half the maxdist; from
+ *               LOAD_MINIMAL waiting batches on
+ *   - REJECTED: the request is answered right away with status RETRY_LATER; with more than
+ *               LOAD_REJECT requests in progress
+ * Degraded requests report the status DEGRADED and the parameters actually used.
+ */
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      class load_controller {
+
+	std::atomic<int>      active;        // requests in progress
+	std::atomic<uint64_t> num_degraded, num_rejected;
+
+      public:
+
+	enum level { NORMAL = 0, DEGRADED = 1, MINIMAL = 2, REJECTED = 3 };
+
+	load_controller();
+
+	/**
+	 * Register a new request and return its level of degradation, given the number of batches
+	 * waiting in the queue of the thread pool. Every call must be followed by a call to leave()
+	 * once the request is done (also for rejected requests).
+	 */
+	level admit(size_t backlog);
+
+	/**
+	 * Unregister a request admitted before.
+	 */
+	void leave();
+
+	/**
+	 * Number of requests in progress, and of degraded and rejected requests so far.
+	 */
+	inline int      requests() const { return active.load(std::memory_order_relaxed); };
+	inline uint64_t degraded() const { return num_degraded.load(std::memory_order_relaxed); };
+	inline uint64_t rejected() const { return num_rejected.load(std::memory_order_relaxed); };
+      };
+
+    }
+  }
+}
+
+#endif
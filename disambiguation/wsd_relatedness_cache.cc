@@ -0,0 +1,194 @@
+#include <float.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "wsd_relatedness_cache.h"
+#include "../graph/hash.h"
+#include "../config.h"
+
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      relatedness_cache::relatedness_cache(size_t entries) : table(NULL) {
+	sets = entries / (RELATEDNESS_CACHE_SHARDS * RELATEDNESS_CACHE_WAYS);
+	if(sets < 1) {
+	  sets = 1;
+	}
+
+	shards = new shard[RELATEDNESS_CACHE_SHARDS];
+	for(int i=0; i<RELATEDNESS_CACHE_SHARDS; i++) {
+	  pthread_mutex_init(&shards[i].mutex,NULL);
+	  shards[i].entries = new entry[sets * RELATEDNESS_CACHE_WAYS];
+	  memset(shards[i].entries, 0, sets * RELATEDNESS_CACHE_WAYS * sizeof(entry));
+	  shards[i].hand      = 0;
+	  shards[i].hits      = 0;
+	  shards[i].misses    = 0;
+	  shards[i].evictions = 0;
+	}
+      }
+
+      relatedness_cache::~relatedness_cache() {
+	for(int i=0; i<RELATEDNESS_CACHE_SHARDS; i++) {
+	  pthread_mutex_destroy(&shards[i].mutex);
+	  delete[] shards[i].entries;
+	}
+	delete[] shards;
+      }
+
+
+      relatedness_cache::shard* relatedness_cache::locate(uint32_t config, uint64_t pair, entry** set) const {
+	uint64_t h = mico::graph::mix64(pair ^ ((uint64_t)config << 40) ^ config);
+	shard*   s = &shards[h % RELATEDNESS_CACHE_SHARDS];
+
+	*set = s->entries + ((h / RELATEDNESS_CACHE_SHARDS) % sets) * RELATEDNESS_CACHE_WAYS;
+	return s;
+      }
+
+
+      bool relatedness_cache::lookup(uint32_t config, int from, int to, double cutoff, double* relatedness) {
+	uint64_t pair = mico::graph::relatedness_table::pair(from, to);
+	entry*   set;
+	shard*   s = locate(config, pair, &set);
+	bool     found = false;
+
+	pthread_mutex_lock(&s->mutex);
+	for(int i=0; i<RELATEDNESS_CACHE_WAYS; i++) {
+	  entry& e = set[i];
+	  if(e.config == config && e.pair == pair) {
+	    if(e.relatedness < DBL_MAX || cutoff <= e.cutoff) {
+	      *relatedness = e.relatedness <= cutoff ? e.relatedness : DBL_MAX;
+	      e.referenced = 1;
+	      found = true;
+	    }
+	    break;
+	  }
+	}
+	pthread_mutex_unlock(&s->mutex);
+
+	// fall back to the precomputed values and keep them in the cache from now on
+	if(!found && table != NULL) {
+	  const mico::graph::relatedness_table::record* p = table->find(config, pair);
+	  if(p != NULL && (p->relatedness < DBL_MAX || cutoff <= p->cutoff)) {
+	    *relatedness = p->relatedness <= cutoff ? p->relatedness : DBL_MAX;
+	    found = true;
+	    insert(config, from, to, p->cutoff, p->relatedness);
+	  }
+	}
+
+	if(found) {
+	  s->hits.fetch_add(1, std::memory_order_relaxed);
+	} else {
+	  s->misses.fetch_add(1, std::memory_order_relaxed);
+	}
+	return found;
+      }
+
+
+      void relatedness_cache::insert(uint32_t config, int from, int to, double cutoff, double relatedness) {
+	uint64_t pair = mico::graph::relatedness_table::pair(from, to);
+	entry*   set;
+	shard*   s = locate(config, pair, &set);
+	entry*   slot = NULL;
+	int      i;
+
+	pthread_mutex_lock(&s->mutex);
+
+	// update the existing entry of the key, or take an empty one
+	for(i=0; i<RELATEDNESS_CACHE_WAYS && slot == NULL; i++) {
+	  if(set[i].config == config && set[i].pair == pair) {
+	    slot = &set[i];
+	  }
+	}
+	for(i=0; i<RELATEDNESS_CACHE_WAYS && slot == NULL; i++) {
+	  if(set[i].config == 0) {
+	    slot = &set[i];
+	  }
+	}
+
+	// CLOCK: advance the hand until an entry without reference bit is found
+	while(slot == NULL) {
+	  entry& e = set[s->hand];
+	  s->hand  = (s->hand + 1) % RELATEDNESS_CACHE_WAYS;
+	  if(e.referenced) {
+	    e.referenced = 0;
+	  } else {
+	    slot = &e;
+	    s->evictions.fetch_add(1, std::memory_order_relaxed);
+	  }
+	}
+
+	slot->pair        = pair;
+	slot->config      = config;
+	slot->referenced  = 0;
+	slot->relatedness = relatedness;
+	slot->cutoff      = cutoff;
+
+	pthread_mutex_unlock(&s->mutex);
+      }
+
+
+      void relatedness_cache::snapshot(std::vector<mico::graph::relatedness_table::record>& records, size_t max) const {
+	mico::graph::relatedness_table::record r;
+	size_t first = records.size();
+	size_t i;
+
+	r.reserved = 0;
+	for(int k=0; k<RELATEDNESS_CACHE_SHARDS; k++) {
+	  pthread_mutex_lock(&shards[k].mutex);
+	  for(i=0; i<sets * RELATEDNESS_CACHE_WAYS && records.size() - first < max; i++) {
+	    const entry& e = shards[k].entries[i];
+	    if(e.config != 0) {
+	      r.pair        = e.pair;
+	      r.config      = e.config;
+	      r.relatedness = e.relatedness;
+	      r.cutoff      = e.cutoff;
+	      records.push_back(r);
+	    }
+	  }
+	  pthread_mutex_unlock(&shards[k].mutex);
+	}
+
+	if(table == NULL || records.size() - first >= max) {
+	  return;
+	}
+
+	// the cache values replace the values of the table
+	std::sort(records.begin() + first, records.end());
+	size_t cached = records.size();
+	for(long j=0; j<table->size && records.size() - first < max; j++) {
+	  if(!std::binary_search(records.begin() + first, records.begin() + cached, table->records[j])) {
+	    records.push_back(table->records[j]);
+	  }
+	}
+      }
+
+
+      uint64_t relatedness_cache::hits() const {
+	uint64_t n = 0;
+	for(int i=0; i<RELATEDNESS_CACHE_SHARDS; i++) {
+	  n += shards[i].hits.load(std::memory_order_relaxed);
+	}
+	return n;
+      }
+
+      uint64_t relatedness_cache::misses() const {
+	uint64_t n = 0;
+	for(int i=0; i<RELATEDNESS_CACHE_SHARDS; i++) {
+	  n += shards[i].misses.load(std::memory_order_relaxed);
+	}
+	return n;
+      }
+
+      uint64_t relatedness_cache::evictions() const {
+	uint64_t n = 0;
+	for(int i=0; i<RELATEDNESS_CACHE_SHARDS; i++) {
+	  n += shards[i].evictions.load(std::memory_order_relaxed);
+	}
+	return n;
+      }
+
+    }
+  }
+}
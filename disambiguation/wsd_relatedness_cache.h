@@ -0,0 +1,109 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_RELATEDNESS_CACHE_H
+#define HAVE_RELATEDNESS_CACHE_H 1
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "../graph/relatedness_table.h"
+
+/**
+ * A process-wide cache of relatedness values, shared by all requests. Popular candidate pairs
+ * (countries, cities, big companies) recur in many requests; with the cache, their relatedness is
+ * only computed once as long as it is used regularly.
+ *
+ * Values are keyed by the algorithm configuration (algorithm and maximum distance) and the pair of
+ * vertice ids. Since search-based algorithms stop at the cutoff of a request, an entry also
+ * records the cutoff it was computed with: a value below DBL_MAX is exact and valid for any cutoff,
+ * "unrelated" (DBL_MAX) only for requests with at most the same cutoff.
+ *
+ * The cache has a fixed number of entries (no allocation after construction). It is divided into
+ * RELATEDNESS_CACHE_SHARDS shards with their own lock, so concurrent workers rarely wait for each
+ * other; within a shard, a key can be stored in one of the RELATEDNESS_CACHE_WAYS entries of its
+ * set. When a set is full, an entry is evicted using the CLOCK algorithm: entries get a reference
+ * bit on every hit, and the clock hand of the shard passes over the set, clearing reference bits,
+ * until it finds an entry that was not referenced since the last pass.
+ *
+ * To be warm right after a restart, the cache can be backed by a relatedness table mapped from
+ * disk: values missing in the cache are looked up in the table (and then kept in the cache), and
+ * the contents of the cache can be written back to a table file (snapshot).
+ */
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      class relatedness_cache {
+
+	struct entry {
+	  uint64_t pair;        // from in the upper, to in the lower 32 bits
+	  uint32_t config;      // algorithm and maximum distance, 0 for empty entries
+	  uint32_t referenced;  // CLOCK reference bit
+	  double   relatedness;
+	  double   cutoff;      // cutoff the value was computed with
+	};
+
+	struct shard {
+	  pthread_mutex_t       mutex;
+	  entry*                entries;
+	  unsigned              hand;       // CLOCK hand, position within a set
+	  std::atomic<uint64_t> hits, misses, evictions;
+	};
+
+	shard* shards;
+	size_t sets;         // number of sets per shard
+
+	// precomputed values consulted on misses (may be NULL)
+	const mico::graph::relatedness_table* table;
+
+	// hash the key and return its shard and the first entry of its set
+	shard* locate(uint32_t config, uint64_t pair, entry** set) const;
+
+      public:
+
+	/**
+	 * Create a cache with (about) the given number of entries.
+	 */
+	relatedness_cache(size_t entries);
+
+	~relatedness_cache();
+
+	/**
+	 * Look up the relatedness of the pair from, to computed with the given algorithm
+	 * configuration. Returns false if the cache does not contain a value that is valid for the
+	 * given cutoff.
+	 */
+	bool lookup(uint32_t config, int from, int to, double cutoff, double* relatedness);
+
+	/**
+	 * Store the relatedness of the pair from, to computed with the given algorithm configuration
+	 * and cutoff.
+	 */
+	void insert(uint32_t config, int from, int to, double cutoff, double relatedness);
+
+	/**
+	 * Use the values of the given table for pairs that are not in the cache. The table must
+	 * stay valid until the cache is destroyed or another table is attached.
+	 */
+	inline void attach(const mico::graph::relatedness_table* table) { this->table = table; };
+
+	/**
+	 * Append the values of the cache to the records, followed by those values of the attached
+	 * table that are not in the cache, up to a total of max records.
+	 */
+	void snapshot(std::vector<mico::graph::relatedness_table::record>& records, size_t max) const;
+
+	/**
+	 * Number of successful and failed lookups and of evicted entries since the cache was created.
+	 */
+	uint64_t hits() const;
+	uint64_t misses() const;
+	uint64_t evictions() const;
+      };
+
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,114 @@
+#include <math.h>
+
+#include "wsd_relatedness_costs.h"
+#include "../config.h"
+
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      relatedness_costs::relatedness_costs(mico::graph::rgraph_complete* graph)
+	: graph(graph), ready(false), adj(NULL), entries(0.0), branching(0.0) {
+	pthread_mutex_init(&mutex,NULL);
+      }
+
+      relatedness_costs::~relatedness_costs() {
+	pthread_mutex_destroy(&mutex);
+      }
+
+
+      void relatedness_costs::prepare() {
+	if(ready.load(std::memory_order_acquire)) {
+	  return;
+	}
+
+	pthread_mutex_lock(&mutex);
+	if(!ready.load(std::memory_order_relaxed)) {
+	  double sum = 0.0, squares = 0.0, d;
+
+	  adj = graph->get_adjacency();
+	  for(int v = 0; v < adj->num_vertices; v++) {
+	    d        = adj->degree(v);
+	    sum     += d;
+	    squares += d * d;
+	  }
+	  entries   = sum;
+	  branching = sum > 0.0 ? squares / sum : 0.0;
+
+	  ready.store(true, std::memory_order_release);
+	}
+	pthread_mutex_unlock(&mutex);
+      }
+
+
+      double relatedness_costs::estimate(DisambiguationRequest::RelatednessAlgorithm algorithm, int from, int to, int max_dist) {
+	prepare();
+	return cost(algorithm, from, to, max_dist);
+      }
+
+
+      double relatedness_costs::cost(DisambiguationRequest::RelatednessAlgorithm algorithm, int from, int to, int max_dist) const {
+	double d = (adj->degree(from) + adj->degree(to)) / 2.0;
+	double visited;
+
+	switch(algorithm) {
+	case DisambiguationRequest::SHORTEST_PATH:
+	case DisambiguationRequest::DFS:
+	  // the search state covers the whole graph; the search visits the vertices up to max_dist
+	  // edges away from the source (the whole graph without limit)
+	  visited = max_dist > 0 ? d * pow(branching, max_dist - 1) : entries;
+	  visited = visited < entries ? visited : entries;
+	  return AUTO_COST_VERTICE * (double)adj->num_vertices
+	    + (algorithm == DisambiguationRequest::SHORTEST_PATH ? AUTO_COST_SEARCH : AUTO_COST_NEIGHBORHOOD) * visited;
+	case DisambiguationRequest::JACCARD:
+	case DisambiguationRequest::ADAMIC_ADAR:
+	  // both neighbor lists, or the neighbor lists of all neighbors (bitmaps for hubs)
+	  visited = max_dist > 1 ? 2.0 * d * (branching < NEIGHBORHOOD_HUB_DEGREE ? branching : NEIGHBORHOOD_HUB_DEGREE) : 2.0 * d;
+	  return AUTO_COST_NEIGHBORHOOD * visited;
+	default:
+	  return AUTO_COST_CONSTANT;
+	}
+      }
+
+
+      DisambiguationRequest::RelatednessAlgorithm relatedness_costs::select(const std::vector<std::pair<int,int> >& pairs, int max_dist,
+									 double budget, double* time) {
+	// most accurate first
+	static const DisambiguationRequest::RelatednessAlgorithm candidates[] = {
+	  DisambiguationRequest::SHORTEST_PATH, DisambiguationRequest::DFS, DisambiguationRequest::ADAMIC_ADAR,
+	  DisambiguationRequest::JACCARD, DisambiguationRequest::SKETCH
+	};
+
+	DisambiguationRequest::RelatednessAlgorithm algorithm = DisambiguationRequest::PARTITION;
+	double total = 0.0;
+
+	prepare();
+
+	for(size_t a = 0; a < sizeof(candidates) / sizeof(candidates[0]); a++) {
+	  if(candidates[a] == DisambiguationRequest::SKETCH && graph->sketch == NULL) {
+	    continue;
+	  }
+
+	  // stop summing up as soon as the budget is exceeded (pairs of hubs are expensive)
+	  total = 0.0;
+	  for(size_t p = 0; p < pairs.size() && total / NUM_THREADS <= budget * 1e6; p++) {
+	    total += cost(candidates[a], pairs[p].first, pairs[p].second, max_dist);
+	  }
+	  if(total / NUM_THREADS <= budget * 1e6) {
+	    algorithm = candidates[a];
+	    break;
+	  }
+	}
+
+	if(algorithm == DisambiguationRequest::PARTITION) {
+	  total = AUTO_COST_CONSTANT * pairs.size();
+	}
+	if(time != NULL) {
+	  *time = total / NUM_THREADS;
+	}
+	return algorithm;
+      }
+
+    }
+  }
+}
@@ -0,0 +1,84 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_RELATEDNESS_COSTS_H
+#define HAVE_RELATEDNESS_COSTS_H 1
+
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <pthread.h>
+
+#include "../graph/rgraph.h"
+#include "../graph/adjacency.h"
+#include "../communication/disambiguation_request.pb.h"
+
+/**
+ * Cost model for the AUTO relatedness algorithm. Clients cannot know how expensive the relatedness
+ * of their candidates is: a SHORTEST_PATH search from a hub explores a large part of the graph,
+ * one from a leaf only a few vertices. The model estimates the time of each relatedness algorithm
+ * for a pair of vertices from their degrees, the maximum distance and the degree distribution of
+ * the graph, so that the server can pick the most accurate algorithm whose estimated time for all
+ * pairs of a request fits the time budget of the request.
+ *
+ * Estimates are in numbers of visited adjacency entries, converted to nanoseconds with the
+ * constants in config.h:
+ *   - SHORTEST_PATH and DFS set up a search state for the whole graph and visit the vertices up
+ *     to max_dist edges away from the source, i.e. about deg * b^(max_dist-1) entries (at most the
+ *     whole graph), where b is the mean degree of a vertice reached over an edge (E[deg^2]/E[deg],
+ *     which is larger than the mean degree in graphs with hubs); DFS needs no priority queue
+ *   - JACCARD and ADAMIC_ADAR merge the two neighbor lists, or the neighbor lists of all
+ *     neighbors for max_dist > 1 (hubs with a precomputed bitmap count as one entry)
+ *   - SKETCH and PARTITION take constant time
+ *
+ * The estimate only depends on the graph and the request, so the selection is deterministic. The
+ * model is owned by the server and shared by all requests; building the adjacency of a large graph
+ * takes a while, so it is set up when the first AUTO request needs it.
+ */
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      class relatedness_costs {
+
+	mico::graph::rgraph_complete* graph;
+
+	// set up on first use
+	pthread_mutex_t               mutex;
+	std::atomic<bool>             ready;
+	const mico::graph::adjacency* adj;
+	double                        entries;    // number of entries of the adjacency (twice the number of edges)
+	double                        branching;  // mean degree of a vertice reached over an edge
+
+	// build the adjacency of the graph if necessary and compute the degree statistics
+	void prepare();
+
+	// estimate for a prepared model
+	double cost(DisambiguationRequest::RelatednessAlgorithm algorithm, int from, int to, int max_dist) const;
+
+      public:
+
+	/**
+	 * Create the model for the graph; it is set up on first use.
+	 */
+	relatedness_costs(mico::graph::rgraph_complete* graph);
+
+	~relatedness_costs();
+
+	/**
+	 * Estimated time in nanoseconds for the relatedness of from and to with the algorithm.
+	 */
+	double estimate(DisambiguationRequest::RelatednessAlgorithm algorithm, int from, int to, int max_dist);
+
+	/**
+	 * The most accurate algorithm whose estimated time for all pairs, computed in parallel by
+	 * the workers of the pool, is at most budget milliseconds (PARTITION if none is). The
+	 * estimated time of the selected algorithm is stored in time (if not NULL).
+	 */
+	DisambiguationRequest::RelatednessAlgorithm select(const std::vector<std::pair<int,int> >& pairs, int max_dist,
+							   double budget, double* time = NULL);
+      };
+
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include <algorithm>
+
+#include "wsd_relatedness_flights.h"
+#include "../graph/hash.h"
+#include "../config.h"
+
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      static inline uint64_t flight_key(uint32_t config, int from) {
+	return ((uint64_t)config << 32) | (uint32_t)from;
+      }
+
+
+      int relatedness_flights::flight::find(int target) const {
+	std::vector<int>::const_iterator it = std::lower_bound(targets.begin(), targets.end(), target);
+	return it != targets.end() && *it == target ? (int)(it - targets.begin()) : -1;
+      }
+
+
+      relatedness_flights::relatedness_flights() : num_coalesced(0), num_merged(0) {
+	shards = new shard[RELATEDNESS_FLIGHT_SHARDS];
+	for(int i=0; i<RELATEDNESS_FLIGHT_SHARDS; i++) {
+	  pthread_mutex_init(&shards[i].mutex,NULL);
+	  pthread_cond_init(&shards[i].cond,NULL);
+	}
+      }
+
+      relatedness_flights::~relatedness_flights() {
+	for(int i=0; i<RELATEDNESS_FLIGHT_SHARDS; i++) {
+	  pthread_mutex_destroy(&shards[i].mutex);
+	  pthread_cond_destroy(&shards[i].cond);
+	}
+	delete[] shards;
+      }
+
+
+      relatedness_flights::shard* relatedness_flights::locate(uint64_t key) const {
+	return &shards[mico::graph::mix64(key) % RELATEDNESS_FLIGHT_SHARDS];
+      }
+
+
+      void relatedness_flights::add_pending(uint32_t config, const void* batch, const std::vector<std::pair<int,int> >& pairs) {
+	for(size_t i = 0; i < pairs.size(); i++) {
+	  uint64_t key = flight_key(config, pairs[i].first);
+	  shard*   s   = locate(key);
+
+	  pthread_mutex_lock(&s->mutex);
+	  s->pending[key][batch].push_back(pairs[i].second);
+	  pthread_mutex_unlock(&s->mutex);
+	}
+      }
+
+      void relatedness_flights::remove_pending(uint32_t config, const void* batch, const std::vector<std::pair<int,int> >& pairs) {
+	// all targets of the batch are removed with the first pair of their source
+	for(size_t i = 0; i < pairs.size(); i++) {
+	  uint64_t key = flight_key(config, pairs[i].first);
+	  shard*   s   = locate(key);
+
+	  pthread_mutex_lock(&s->mutex);
+	  std::unordered_map<uint64_t, targets_by_batch>::iterator it = s->pending.find(key);
+	  if(it != s->pending.end()) {
+	    it->second.erase(batch);
+	    if(it->second.empty()) {
+	      s->pending.erase(it);
+	    }
+	  }
+	  pthread_mutex_unlock(&s->mutex);
+	}
+      }
+
+
+      std::shared_ptr<relatedness_flights::flight> relatedness_flights::acquire(uint32_t config, const void* batch, int from, const std::vector<int>& targets,
+										double cutoff, bool* owner) {
+	std::shared_ptr<flight> f;
+	std::vector<int> own;
+	uint64_t key = flight_key(config, from);
+	size_t   i, n = 0;
+
+	*owner = false;
+
+	shard* s = locate(key);
+	pthread_mutex_lock(&s->mutex);
+	std::unordered_map<uint64_t, std::shared_ptr<flight> >::iterator it = s->flights.find(key);
+	if(it != s->flights.end()) {
+	  // wait for the flight in progress if it computes some of the targets
+	  for(i = 0; i < targets.size(); i++) {
+	    if(it->second->find(targets[i]) >= 0) {
+	      n++;
+	    }
+	  }
+	  if(n > 0) {
+	    f = it->second;
+	    while(!f->landed) {
+	      pthread_cond_wait(&s->cond, &s->mutex);
+	    }
+	  }
+	} else {
+	  // start a new flight, taking along the targets other requests are waiting for
+	  f = std::make_shared<flight>();
+	  f->targets = targets;
+	  f->cutoff  = cutoff;
+	  f->landed  = false;
+
+	  // targets of this batch vs. targets merged from other batches
+	  own = targets;
+	  std::unordered_map<uint64_t, targets_by_batch>::iterator p = s->pending.find(key);
+	  if(p != s->pending.end()) {
+	    for(targets_by_batch::iterator b = p->second.begin(); b != p->second.end(); ++b) {
+	      f->targets.insert(f->targets.end(), b->second.begin(), b->second.end());
+	      if(b->first == batch) {
+		own.insert(own.end(), b->second.begin(), b->second.end());
+	      }
+	    }
+	  }
+	  std::sort(f->targets.begin(), f->targets.end());
+	  f->targets.erase(std::unique(f->targets.begin(), f->targets.end()), f->targets.end());
+	  f->results.resize(f->targets.size());
+
+	  std::sort(own.begin(), own.end());
+	  n = std::unique(own.begin(), own.end()) - own.begin();
+
+	  s->flights[key] = f;
+	  *owner = true;
+	}
+	pthread_mutex_unlock(&s->mutex);
+
+	if(*owner) {
+	  num_merged.fetch_add(f->targets.size() - n, std::memory_order_relaxed);
+	} else {
+	  num_coalesced.fetch_add(n, std::memory_order_relaxed);
+	}
+	return f;
+      }
+
+
+      void relatedness_flights::land(uint32_t config, int from, const std::shared_ptr<flight>& f) {
+	uint64_t key = flight_key(config, from);
+	shard*   s   = locate(key);
+
+	pthread_mutex_lock(&s->mutex);
+	f->landed = true;
+	s->flights.erase(key);
+	pthread_cond_broadcast(&s->cond);
+	pthread_mutex_unlock(&s->mutex);
+      }
+
+    }
+  }
+}
@@ -0,0 +1,115 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_RELATEDNESS_FLIGHTS_H
+#define HAVE_RELATEDNESS_FLIGHTS_H 1
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+
+/**
+ * Coalescing of relatedness computations of concurrent requests ("single flight"). Several
+ * connection workers often need the same pairs at the same moment (e.g. the candidates of a
+ * breaking news topic); without coordination, each of their batches would compute them again.
+ *
+ * Computations are grouped by algorithm configuration and source vertice: a worker computing the
+ * relatedness of a source to some targets registers a flight with the targets, and runs a single
+ * one-to-many search for them. Workers needing one of these targets in the meantime wait for the
+ * flight to land and take its result instead of computing it again.
+ *
+ * The pool also registers the pairs of all submitted batches as pending. A new flight from a source
+ * also takes the pending targets of this source in other requests, so searches from the same
+ * source are merged across requests; the results end up in the relatedness cache, where the other
+ * requests find them.
+ *
+ * Every batch registers and unregisters all of its pairs, so the state is divided into
+ * RELATEDNESS_FLIGHT_SHARDS shards by configuration and source, each with its own lock, and the
+ * pending targets of a source are kept per batch, so that a batch is unregistered in constant time
+ * per pair.
+ */
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      class relatedness_flights {
+
+      public:
+
+	struct flight {
+	  std::vector<int>    targets;  // sorted
+	  std::vector<double> results;  // relatedness of the targets, valid once landed
+	  double              cutoff;   // cutoff the results are computed with
+	  bool                landed;
+
+	  // index of the target in the flight, -1 if it is not part of it
+	  int find(int target) const;
+	};
+
+      private:
+
+	// targets of a source pending in submitted batches, by batch
+	typedef std::unordered_map<const void*, std::vector<int> > targets_by_batch;
+
+	struct shard {
+	  pthread_mutex_t mutex;
+	  pthread_cond_t  cond;   // signalled when a flight of the shard has landed
+
+	  // flights in progress and pending targets, by configuration (upper 32 bits) and source
+	  std::unordered_map<uint64_t, std::shared_ptr<flight> > flights;
+	  std::unordered_map<uint64_t, targets_by_batch>         pending;
+	};
+
+	shard* shards;
+
+	std::atomic<uint64_t> num_coalesced, num_merged;
+
+	// the shard of the flights and pending targets with the given key
+	shard* locate(uint64_t key) const;
+
+      public:
+
+	relatedness_flights();
+
+	~relatedness_flights();
+
+	/**
+	 * Register / unregister the pairs (from, to) requested by a submitted batch.
+	 */
+	void add_pending(uint32_t config, const void* batch, const std::vector<std::pair<int,int> >& pairs);
+	void remove_pending(uint32_t config, const void* batch, const std::vector<std::pair<int,int> >& pairs);
+
+	/**
+	 * Get the relatedness of the source to the given targets:
+	 *  - if a flight from the source to some of the targets is in progress, wait until it has
+	 *    landed and return it (owner is false),
+	 *  - if a flight from the source to other targets is in progress, return NULL; the caller
+	 *    computes the values on its own,
+	 *  - otherwise, start a flight to the targets and the pending targets of the source and return
+	 *    it (owner is true); the caller has to compute the relatedness of all targets of the
+	 *    flight and then call land().
+	 * batch is the batch that registered the targets as pending (if any); its own pending targets do
+	 * not count as merged.
+	 */
+	std::shared_ptr<flight> acquire(uint32_t config, const void* batch, int from, const std::vector<int>& targets,
+					double cutoff, bool* owner);
+
+	/**
+	 * Publish the results of a flight and wake up the waiting workers.
+	 */
+	void land(uint32_t config, int from, const std::shared_ptr<flight>& f);
+
+	/**
+	 * Number of tasks answered by the flight of another worker, and of targets added to a flight
+	 * from other batches.
+	 */
+	inline uint64_t coalesced() const { return num_coalesced.load(std::memory_order_relaxed); };
+	inline uint64_t merged() const { return num_merged.load(std::memory_order_relaxed); };
+      };
+
+    }
+  }
+}
+
+#endif
@@ -1,10 +1,18 @@
 #include <iostream>
 #include <vector>
+#include <algorithm>
 
 #include <float.h>
 #include <limits.h>
+#include <time.h>
 
 #include "../threading/thread.h"
+#include "../relatedness/relatedness_shortest_path.h"
+#include "../relatedness/relatedness_dfs.h"
+#include "../relatedness/relatedness_cluster.h"
+#include "../relatedness/relatedness_neighborhood.h"
+#include "../relatedness/relatedness_sketch.h"
+#include "../relatedness/relatedness_embedding.h"
 #include "wsd_relatedness_worker.h"
 
 using namespace mico::graph;
@@ -14,120 +22,503 @@ namespace mico {
     namespace wsd {
 
       /**
-       * Execute worker. While the shared threadpool queue contains more relatedness tasks, take
-       * next task, compute relatedness, and update the WSD graph and weights.
+       * Create a new instance of the given relatedness algorithm.
        */
-      void relatedness_worker::run() {
+      mico::relatedness::base* create_algorithm(DisambiguationRequest::RelatednessAlgorithm algorithm, rgraph_complete* graph, int max_dist) {
+	switch(algorithm) {
+	case DisambiguationRequest::SHORTEST_PATH:
+	  return new mico::relatedness::shortest_path(graph,max_dist);
+	case DisambiguationRequest::DFS:
+	  return new mico::relatedness::dfs(graph,max_dist);
+	case DisambiguationRequest::JACCARD:
+	  return new mico::relatedness::jaccard(graph,max_dist);
+	case DisambiguationRequest::ADAMIC_ADAR:
+	  return new mico::relatedness::adamic_adar(graph,max_dist);
+	case DisambiguationRequest::SKETCH:
+	  return new mico::relatedness::sketch(graph,max_dist);
+	case DisambiguationRequest::EMBEDDING:
+	  return new mico::relatedness::embedding(graph,max_dist);
+	case DisambiguationRequest::PARTITION:
+	default:
+	  return new mico::relatedness::cluster(graph,max_dist);
+	}
+      }
 
-	// loop until queue of thread pool is empty
-	while(1) {
 
-	  // atomic queue access
-	  pthread_mutex_lock(&pool->tsk_mutex);
-	  if(!pool->tasks.empty()) {
-	    // take next task and unlock
-	    rtask t = pool->tasks.front();
-	    pool->tasks.pop();
-	    pthread_mutex_unlock(&pool->tsk_mutex);
+      relatedness_batch::relatedness_batch(DisambiguationRequest::RelatednessAlgorithm algorithm, int max_dist, double cutoff)
+	: algorithm(algorithm), max_dist(max_dist), cutoff(cutoff) {
+	symmetric = is_symmetric(algorithm);
 
-	    // compute relatedness
-	    t.relatedness = pool->states[id]->relatedness(t.from, t.to);
+	// the other algorithms take about as long as a cache lookup
+	cached    = algorithm == DisambiguationRequest::SHORTEST_PATH || algorithm == DisambiguationRequest::DFS
+	  || algorithm == DisambiguationRequest::JACCARD || algorithm == DisambiguationRequest::ADAMIC_ADAR;
 
-	    // if relatedness value is relevant, add it to the results
-	    if(t.relatedness < DBL_MAX) {
-	      pthread_mutex_lock(&pool->wsd_mutex);
-	      igraph_add_edge(&pool->wsd_graph,t.fromId,t.toId);
-	      igraph_vector_push_back (&pool->wsd_weights, t.relatedness);
-	      pthread_mutex_unlock(&pool->wsd_mutex);
-	    }
+	// only shortest path computes several targets of a source in one search
+	merged    = algorithm == DisambiguationRequest::SHORTEST_PATH;
+      }
 
-      
-	  } else {
-	    // unlock and end, no more tasks
-	    pthread_mutex_unlock(&pool->tsk_mutex);
-	    break;
-	  } 
-    
+
+      bool relatedness_batch::is_symmetric(DisambiguationRequest::RelatednessAlgorithm algorithm) {
+	// shortest path and DFS only search the neighborhood of the start vertice, so the result
+	// depends on the direction; AUTO may select one of them
+	return algorithm != DisambiguationRequest::SHORTEST_PATH && algorithm != DisambiguationRequest::DFS
+	  && algorithm != DisambiguationRequest::AUTO;
+      }
+
+
+      size_t relatedness_batch::add_pair(int from, int to) {
+	if(symmetric && to < from) {
+	  std::swap(from, to);
+	}
+
+	uint64_t key = ((uint64_t)(uint32_t)from << 32) | (uint32_t)to;
+	std::pair<std::unordered_map<uint64_t, size_t>::iterator, bool> r = pairs.insert(std::make_pair(key, tasks.size()));
+	if(r.second) {
+	  rtask task = {from, to, DBL_MAX, false};
+	  tasks.push_back(task);
 	}
+	return r.first->second;
+      }
 
 
+      void relatedness_batch::add_task(int from, int to, int fromId, int toId) {
+	redge edge = {fromId, toId, add_pair(from, to)};
+	edges.push_back(edge);
       }
 
+
+      bool relatedness_batch::lookup(int from, int to, double* relatedness) const {
+	if(symmetric && to < from) {
+	  std::swap(from, to);
+	}
+
+	std::unordered_map<uint64_t, size_t>::const_iterator it = pairs.find(((uint64_t)(uint32_t)from << 32) | (uint32_t)to);
+	if(it == pairs.end() || !tasks[it->second].computed) {
+	  return false;
+	}
+	*relatedness = tasks[it->second].relatedness;
+	return true;
+      }
+
+
       /**
-       * Constructor. Initialise instance variables and mutexes.
+       * Collect all related edges and add them to the WSD graph at once (adding edges one by one
+       * rebuilds the igraph indexes for every edge).
        */
-      relatedness_threadpool_base::relatedness_threadpool_base(rgraph_complete* graph, igraph_t& wsd_graph, igraph_vector_t& wsd_weights, int max_dist) 
-	: graph(graph), wsd_graph(wsd_graph), wsd_weights(wsd_weights), max_dist(max_dist) {
-	pthread_mutex_init(&wsd_mutex,NULL);
-	pthread_mutex_init(&tsk_mutex,NULL);
-    
-	initialised = false; // indicate threads still need to be initialised
+      void relatedness_batch::add_edges(igraph_t* wsd_graph, igraph_vector_t* wsd_weights) const {
+	igraph_vector_t wsd_edges;
+	igraph_vector_init(&wsd_edges,0);
+	igraph_vector_reserve(&wsd_edges,2*edges.size());
+	igraph_vector_reserve(wsd_weights,igraph_vector_size(wsd_weights) + edges.size());
+
+	for(std::vector<redge>::const_iterator it = edges.begin(); it != edges.end(); ++it) {
+	  double r = tasks[it->task].relatedness;
+	  if(tasks[it->task].computed && r < DBL_MAX) {
+	    igraph_vector_push_back(&wsd_edges, it->fromId);
+	    igraph_vector_push_back(&wsd_edges, it->toId);
+	    igraph_vector_push_back(wsd_weights, r);
+	  }
+	}
+
+	igraph_add_edges(wsd_graph, &wsd_edges, 0);
+	igraph_vector_destroy(&wsd_edges);
+      }
 
-      };
 
       /**
-       * Destructor. If thread pool was initialised, clean it up. Destroy mutexes afterwards.
+       * Destructor. Release the algorithm states of the worker.
        */
-      relatedness_threadpool_base::~relatedness_threadpool_base()  {
-	// destroy threads and states
-	if(initialised) {
-	  for(int i=0; i<NUM_THREADS; i++) {
-	    delete pool[i];
-	    delete states[i];
+      relatedness_worker::~relatedness_worker() {
+	for(std::map<int, mico::relatedness::base*>::iterator it = states.begin(); it != states.end(); ++it) {
+	  delete it->second;
+	}
+      }
+
+      /**
+       * Return the algorithm instance for the batch, creating it on first use.
+       */
+      mico::relatedness::base* relatedness_worker::state(const relatedness_batch& batch) {
+	mico::relatedness::base* s = states[batch.algorithm];
+	if(s == NULL) {
+	  s = create_algorithm(batch.algorithm, pool->graph, batch.max_dist);
+	  states[batch.algorithm] = s;
+	}
+	s->set_max_dist(batch.max_dist);
+	s->set_cutoff(batch.cutoff);
+	return s;
+      }
+
+
+      /**
+       * Reserve the parallel shortest path algorithm of the pool for the next task of the batch, if
+       * it is not in use by another worker.
+       */
+      bool relatedness_worker::claim_parallel(const relatedness_batch& batch) {
+	bool claimed = false;
+
+	pthread_mutex_lock(&pool->tsk_mutex);
+	if(!pool->parallel_busy && pool->batches.size() <= 1) {
+	  if(pool->parallel == NULL) {
+	    pool->parallel = new mico::relatedness::delta_stepping(pool->graph,batch.max_dist);
 	  }
+	  pool->parallel->set_max_dist(batch.max_dist);
+	  pool->parallel->set_cutoff(batch.cutoff);
+	  pool->parallel_busy = true;
+	  pool->parallel_searches++;
+	  pthread_cond_broadcast(&pool->tsk_cond);
+	  claimed = true;
 	}
-	
-	pthread_mutex_destroy(&wsd_mutex);
-	pthread_mutex_destroy(&tsk_mutex);
+	pthread_mutex_unlock(&pool->tsk_mutex);
 
-      };
+	return claimed;
+      }
+
+      double relatedness_worker::parallel_relatedness(int from, int to) {
+	double r = pool->parallel->relatedness(from, to);
+
+	pthread_mutex_lock(&pool->tsk_mutex);
+	pool->parallel_busy = false;
+	pthread_cond_broadcast(&pool->tsk_cond);
+	pthread_mutex_unlock(&pool->tsk_mutex);
+
+	return r;
+      }
 
 
       /**
-       * Start working on the tasks currently contained in the queue. If necessary, the thread pool
-       * is first initialised.
+       * Compute the relatedness of the tasks first..last-1 and store the results in the tasks.
+       * Values found in the cache of the pool are not computed again; the others are computed
+       * grouped by source vertice. Once fewer tasks than threads remain, shortest path tasks with
+       * a large maximum distance are computed by the parallel algorithm.
        */
-      void relatedness_threadpool_base::start()  {
-	if(!initialised) {
-	  // create threads and states
-	  for(int i=0; i<NUM_THREADS; i++) {
-	    states[i] = create_algorithm();
-	    pool[i]   = new relatedness_worker(i,this);
+      void relatedness_batch::compute(relatedness_worker& worker, size_t first, size_t last) {
+	mico::relatedness::base* s = worker.state(*this);
+	relatedness_cache&       cache = worker.pool->cache;
+	uint32_t                 config = mico::graph::relatedness_table::config(algorithm, max_dist);
+	size_t size = tasks.size();
+	size_t k, g;
+
+	bool tail_parallel = algorithm == DisambiguationRequest::SHORTEST_PATH && max_dist >= DELTA_STEPPING_MIN_DIST;
+
+	std::vector<std::pair<int, size_t> > missing;
+
+	for(k = first; k < last; k++) {
+	  rtask& task = tasks[k];
+	  double r;
+
+	  if(cached && cache.lookup(config, task.from, task.to, cutoff, &r)) {
+	    task.relatedness = r;
+	    task.computed    = true;
+	    continue;
+	  }
+
+	  if(cached && !(tail_parallel && size - k < NUM_THREADS)) {
+	    missing.push_back(std::make_pair(task.from, k));
+	    continue;
+	  }
+
+	  // compute relatedness; values above the cutoff are not relevant
+	  if(tail_parallel && size - k < NUM_THREADS && worker.claim_parallel(*this)) {
+	    r = worker.parallel_relatedness(task.from, task.to);
+	  } else {
+	    r = s->relatedness(task.from, task.to);
+	  }
+
+	  task.relatedness = r <= cutoff ? r : DBL_MAX;
+	  task.computed    = true;
+
+	  if(cached) {
+	    cache.insert(config, task.from, task.to, cutoff, task.relatedness);
 	  }
-	  initialised = true;
 	}
 
-	// destroy threads and states
+	// compute the missing values per source
+	std::sort(missing.begin(), missing.end());
+	std::vector<size_t> group;
+	for(k = 0; k < missing.size(); k = g) {
+	  group.clear();
+	  for(g = k; g < missing.size() && missing[g].first == missing[k].first; g++) {
+	    group.push_back(missing[g].second);
+	  }
+	  compute_source(worker, missing[k].first, group);
+	}
+      }
+
+
+      /**
+       * Compute the tasks of the group (all starting at source) together with the computations of
+       * other requests: tasks that are part of a flight in progress take its results, the others
+       * are computed by a flight of this worker, which also computes the pending targets of the
+       * source. If another worker computes other targets of the source, the group is computed
+       * without flight.
+       */
+      void relatedness_batch::compute_source(relatedness_worker& worker, int source, std::vector<size_t>& group) {
+	mico::relatedness::base* s = worker.state(*this);
+	relatedness_cache&       cache = worker.pool->cache;
+	relatedness_flights&     flights = worker.pool->flights;
+	uint32_t                 config = mico::graph::relatedness_table::config(algorithm, max_dist);
+	std::vector<int>         targets;
+	std::vector<double>      results;
+	std::vector<size_t>      rest;
+	bool                     owner;
+	size_t                   k, i;
+	int                      p;
+
+	while(!group.empty()) {
+	  targets.clear();
+	  for(k = 0; k < group.size(); k++) {
+	    targets.push_back(tasks[group[k]].to);
+	  }
+
+	  std::shared_ptr<relatedness_flights::flight> f = flights.acquire(config, this, source, targets, cutoff, &owner);
+
+	  if(!f) {
+	    // another worker searches from the source for other targets
+	    results.resize(targets.size());
+	    s->relatedness(source, &targets[0], targets.size(), &results[0]);
+	    for(k = 0; k < group.size(); k++) {
+	      rtask& task = tasks[group[k]];
+	      task.relatedness = results[k] <= cutoff ? results[k] : DBL_MAX;
+	      task.computed    = true;
+	      cache.insert(config, task.from, task.to, cutoff, task.relatedness);
+	    }
+	    return;
+	  }
+
+	  if(owner) {
+	    s->relatedness(source, &f->targets[0], f->targets.size(), &f->results[0]);
+	    for(i = 0; i < f->targets.size(); i++) {
+	      if(f->results[i] > cutoff) {
+		f->results[i] = DBL_MAX;
+	      }
+	      cache.insert(config, source, f->targets[i], cutoff, f->results[i]);
+	    }
+	    flights.land(config, source, f);
+	  }
+
+	  // take the results of the flight that are valid for the cutoff of this batch
+	  rest.clear();
+	  for(k = 0; k < group.size(); k++) {
+	    rtask& task = tasks[group[k]];
+	    p = f->find(task.to);
+	    if(p >= 0 && (f->results[p] < DBL_MAX || cutoff <= f->cutoff)) {
+	      task.relatedness = f->results[p] <= cutoff ? f->results[p] : DBL_MAX;
+	      task.computed    = true;
+	    } else if(p >= 0) {
+	      // computed with a smaller cutoff
+	      task.relatedness = s->relatedness(task.from, task.to);
+	      task.relatedness = task.relatedness <= cutoff ? task.relatedness : DBL_MAX;
+	      task.computed    = true;
+	      cache.insert(config, task.from, task.to, cutoff, task.relatedness);
+	    } else {
+	      rest.push_back(group[k]);
+	    }
+	  }
+	  group.swap(rest);
+	}
+      }
+
+
+      void relatedness_batch::submitted(relatedness_threadpool& pool) {
+	if(merged) {
+	  pending.resize(tasks.size());
+	  for(size_t k = 0; k < tasks.size(); k++) {
+	    pending[k] = std::make_pair(tasks[k].from, tasks[k].to);
+	  }
+	  pool.flights.add_pending(mico::graph::relatedness_table::config(algorithm, max_dist), this, pending);
+	}
+      }
+
+      void relatedness_batch::completed(relatedness_threadpool& pool) {
+	if(merged) {
+	  pool.flights.remove_pending(mico::graph::relatedness_table::config(algorithm, max_dist), this, pending);
+	  pending.clear();
+	}
+      }
+
+
+      /**
+       * Compute tasks of the batch until all of them have been handed out. Tasks are claimed in
+       * chunks by advancing the atomic cursor of the batch; the chunk size is chosen so that a chunk
+       * takes about TASK_CHUNK_TIME, but at most half of the remaining tasks per worker are taken.
+       * Once the deadline of the batch has passed, no more tasks are handed out.
+       */
+      void relatedness_worker::process(pool_batch& b) {
+	size_t size = b.size();
+	size_t first, n, remaining;
+	long   t, limit;
+	struct timespec start, end;
+
+	while(1) {
+	  first = b.next.load(std::memory_order_relaxed);
+	  if(first >= size) {
+	    break;
+	  }
+
+	  if(b.has_deadline) {
+	    clock_gettime(CLOCK_MONOTONIC, &start);
+	    if(start.tv_sec > b.deadline.tv_sec || (start.tv_sec == b.deadline.tv_sec && start.tv_nsec >= b.deadline.tv_nsec)) {
+	      b.expired.store(true);
+	      b.next.store(size);
+	      break;
+	    }
+	  }
+
+	  // adaptive chunk size
+	  remaining = size - first;
+	  t         = b.task_time.load(std::memory_order_relaxed);
+	  limit     = t > 0 ? TASK_CHUNK_TIME / t : 1;
+	  n         = remaining / (2 * NUM_THREADS);
+	  if(n > (size_t)limit) {
+	    n = limit;
+	  }
+	  if(n > TASK_CHUNK_MAX) {
+	    n = TASK_CHUNK_MAX;
+	  }
+	  if(n < 1) {
+	    n = 1;
+	  }
+
+	  if(!b.next.compare_exchange_weak(first, first + n, std::memory_order_relaxed)) {
+	    continue;
+	  }
+
+	  clock_gettime(CLOCK_MONOTONIC, &start);
+
+	  b.compute(*this, first, first + n);
+
+	  clock_gettime(CLOCK_MONOTONIC, &end);
+	  t = ((end.tv_sec - start.tv_sec) * 1000000000L + end.tv_nsec - start.tv_nsec) / (long)n;
+	  b.task_time.store(t > 0 ? t : 1, std::memory_order_relaxed);
+	}
+      }
+
+
+      /**
+       * Execute worker. While the pool has batches with more relatedness tasks, compute tasks of
+       * the first batch and store the results in the tasks. When there are no tasks, help with a
+       * running parallel computation or wait for new batches.
+       */
+      void relatedness_worker::run() {
+	unsigned helped = 0;
+
+	// atomic queue access
+	pthread_mutex_lock(&pool->tsk_mutex);
+
+	// loop until the pool is shut down
+	while(!pool->shutdown) {
+
+	  if(!pool->batches.empty()) {
+	    pool_batch* b = pool->batches.front();
+	    b->workers++;
+	    pthread_mutex_unlock(&pool->tsk_mutex);
+
+	    process(*b);
+
+	    // all tasks of the batch have been handed out; the last worker to leave completes it
+	    pthread_mutex_lock(&pool->tsk_mutex);
+	    if(b->queued) {
+	      pool->batches.remove(b);
+	      b->queued = false;
+	    }
+	    b->workers--;
+	    if(b->workers == 0) {
+	      b->finished = true;
+	      pthread_cond_broadcast(&pool->done_cond);
+	    }
+
+	  } else if(pool->parallel_busy && helped != pool->parallel_searches) {
+	    // help with the parallel computation of another worker
+	    helped = pool->parallel_searches;
+	    pthread_mutex_unlock(&pool->tsk_mutex);
+
+	    pool->parallel->help(helped);
+
+	    pthread_mutex_lock(&pool->tsk_mutex);
+	  } else {
+	    // wait for new tasks
+	    pthread_cond_wait(&pool->tsk_cond, &pool->tsk_mutex);
+	  }
+
+	}
+	pthread_mutex_unlock(&pool->tsk_mutex);
+
+      }
+
+      /**
+       * Constructor. Initialise instance variables and mutexes, and start the worker threads.
+       */
+      relatedness_threadpool::relatedness_threadpool(rgraph_complete* graph)
+	: cache(RELATEDNESS_CACHE_ENTRIES), parallel(NULL), parallel_searches(0), parallel_busy(false), shutdown(false), graph(graph) {
+	pthread_mutex_init(&tsk_mutex,NULL);
+	pthread_cond_init(&tsk_cond,NULL);
+	pthread_cond_init(&done_cond,NULL);
+
 	for(int i=0; i<NUM_THREADS; i++) {
+	  pool[i] = new relatedness_worker(i,this);
 	  pool[i]->start();
 	}
-
       };
 
       /**
-       * Reset all worker threads in the pool.
+       * Destructor. Stop all workers and clean up. Destroy mutexes afterwards.
        */
-      void relatedness_threadpool_base::reset()  {
+      relatedness_threadpool::~relatedness_threadpool()  {
+	pthread_mutex_lock(&tsk_mutex);
+	shutdown = true;
+	pthread_cond_broadcast(&tsk_cond);
+	pthread_mutex_unlock(&tsk_mutex);
+
 	// destroy threads and states
-	if(initialised) {
-	  for(int i=0; i<NUM_THREADS; i++) {
-	    pool[i]->reset();
-	  }
+	for(int i=0; i<NUM_THREADS; i++) {
+	  pool[i]->join();
+	  delete pool[i];
 	}
+	delete parallel;
+
+	pthread_mutex_destroy(&tsk_mutex);
+	pthread_cond_destroy(&tsk_cond);
+	pthread_cond_destroy(&done_cond);
 
       };
 
+
       /**
-       * Wait until all workers have finished processing their tasks.
+       * The batches in the queue are those whose tasks have not all been handed out to the workers.
        */
-      void relatedness_threadpool_base::join()  {
-	// destroy threads and states
-	if(initialised) {
-	  for(int i=0; i<NUM_THREADS; i++) {
-	    pool[i]->join();
-	  }
+      size_t relatedness_threadpool::backlog() {
+	size_t n;
+
+	pthread_mutex_lock(&tsk_mutex);
+	n = batches.size();
+	pthread_mutex_unlock(&tsk_mutex);
+
+	return n;
+      }
+
+
+      /**
+       * Add the batch to the queue and wait until all of its tasks have been completed.
+       */
+      void relatedness_threadpool::execute(pool_batch& batch)  {
+	if(batch.size() == 0) {
+	  return;
 	}
 
+	batch.submitted(*this);
+
+	pthread_mutex_lock(&tsk_mutex);
+	batch.queued = true;
+	batches.push_back(&batch);
+	pthread_cond_broadcast(&tsk_cond);
+
+	while(!batch.finished) {
+	  pthread_cond_wait(&done_cond, &tsk_mutex);
+	}
+	pthread_mutex_unlock(&tsk_mutex);
+
+	batch.completed(*this);
+
       };
 
 
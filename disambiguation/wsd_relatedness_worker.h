@@ -2,150 +2,373 @@
 #ifndef HAVE_RELATEDNESS_WORKER_H
 #define HAVE_RELATEDNESS_WORKER_H 1
 
+#include <map>
+#include <list>
 #include <vector>
-#include <queue>
+#include <atomic>
+#include <unordered_map>
+#include <float.h>
+#include <stdint.h>
+#include <time.h>
 #include <igraph/igraph.h>
 
 #include "../threading/thread.h"
 #include "../relatedness/relatedness_base.h"
+#include "../relatedness/relatedness_delta_stepping.h"
+#include "wsd_relatedness_cache.h"
+#include "wsd_relatedness_flights.h"
 #include "../graph/rgraph.h"
+#include "../communication/disambiguation_request.pb.h"
 
 /**
  * This module implements a multi-threaded computation of relatedness values using a fixed-size
- * thread pool. Since we intend to support different relatedness algorithms, the main threadpool
- * class is a template class with a single method for creating new instances of the relatedness
- * algorithm. In case the standard constructor is not applicable for a certain algorithm, custom
- * subclassing of relatedness_threadpool_base is also possible.
+ * thread pool. The pool is created once per server process; its worker threads live as long as the
+ * pool and keep one instance of each relatedness algorithm they have used so far, so the helper
+ * structures of the algorithms (often of the size of the knowledge graph) are only allocated once.
+ * Requests submit their relatedness tasks as a batch and wait for its completion; batches of
+ * concurrent requests are processed in order of submission.
  *
  * Usage:
- *   // create new pool for a given WSD graph and weights vector
- *   relatedness_threadpool<shortest_path> pool(graph,wsd_graph,wsd_weights,maxdist());
- *  
- *   // add relatedness tasks to the shared queue	  
- *   rtask task = {get_node_label(i,t), get_node_label(j,s), get_node_id(i,t),get_node_id(j,s), 0.0};
- *   pool.add_task(task);
+ *   // create new pool for a given knowledge graph (once)
+ *   relatedness_threadpool pool(graph);
  *
- *   // start execution
- *   pool.start();
+ *   // collect the relatedness tasks of a request in a batch
+ *   relatedness_batch batch(DisambiguationRequest::SHORTEST_PATH,maxdist(),cutoff);
+ *   batch.add_task(graph->get_vertice_id(uri_from), graph->get_vertice_id(uri_to), get_node_id(i,t), get_node_id(j,s));
  *
- *   // wait for completion
- *   pool.join()
- * 
- *   // reset for next executions
- *   pool.reset()
+ *   // compute all tasks and wait for completion
+ *   pool.execute(batch);
+ *
+ *   // add the results to the WSD graph and weights vector
+ *   batch.add_edges(&wsd_graph, &wsd_weights);
+ *
+ * Workers store the result of each task in the task itself, so they never need to synchronize
+ * for writing results; the WSD graph is built in one step once the batch is completed. A batch
+ * contains every pair of knowledge graph vertices only once (for symmetric algorithms also only
+ * one direction), even if the same candidate occurs for several entities; the result is then
+ * used for all edges of the WSD graph between candidates with these vertices. Tasks are
+ * handed out in chunks using an atomic cursor over the task array of the batch. The chunk size
+ * adapts to the measured cost of the tasks: cheap tasks (e.g. PARTITION) are taken in large
+ * chunks, expensive ones (e.g. SHORTEST_PATH) one by one, and chunks get smaller towards the end
+ * of a batch so all workers finish at about the same time.
+ *
+ * For shortest path computations with a large maximum distance, the pool also holds a parallel
+ * version of the algorithm: once fewer tasks than threads remain, the next task is computed by
+ * this parallel version, and workers that run out of tasks help with it instead of idling while
+ * the remaining long-running tasks finish.
+ *
+ * Relatedness values of the expensive algorithms (SHORTEST_PATH, DFS, JACCARD, ADAMIC_ADAR) are
+ * kept in a cache shared by all requests; workers look up each task in the cache before computing
+ * it. Tasks missing in the cache are computed per source vertice, coalesced with the computations
+ * of concurrent requests (see relatedness_flights).
+ *
+ * Besides relatedness batches, the pool computes any other kind of independent tasks submitted as
+ * a pool_batch (e.g. the per-vertice searches of betweenness and closeness centrality).
  */
 namespace mico {
   namespace disambiguation {
 
     namespace wsd {
 
+      class relatedness_worker;
+      class relatedness_threadpool;
+
+      /**
+       * Work submitted to the thread pool: a number of independent tasks that are handed out to the
+       * workers in chunks. Subclasses define how a chunk of tasks is computed.
+       */
+      class pool_batch {
+
+	friend class relatedness_worker;
+	friend class relatedness_threadpool;
+
+	std::atomic<size_t> next;      // next task to be handed out
+	std::atomic<long>   task_time; // estimated time per task in nanoseconds (0 = unknown)
+
+	bool                has_deadline;
+	struct timespec     deadline;  // no more tasks are handed out after this time (CLOCK_MONOTONIC)
+	std::atomic<bool>   expired;   // the deadline has passed before all tasks were handed out
+
+	// the following fields are protected by the pool's queue mutex
+	int                 workers;   // number of workers currently taking tasks from this batch
+	bool                queued;    // batch is in the queue of the pool
+	bool                finished;
+
+      public:
+
+	pool_batch() : next(0), task_time(0), has_deadline(false), expired(false), workers(0), queued(false), finished(false) {};
+
+	virtual ~pool_batch() {};
+
+	/**
+	 * Stop handing out tasks of the batch at the given time (CLOCK_MONOTONIC); tasks already
+	 * being computed are finished, the others remain uncomputed.
+	 */
+	inline void set_deadline(const struct timespec& t) {
+	  has_deadline = true;
+	  deadline     = t;
+	};
+
+	/**
+	 * True if the deadline has passed before all tasks of the (completed) batch were computed.
+	 */
+	inline bool is_expired() const { return expired.load(); };
+
+	/**
+	 * Number of tasks in the batch.
+	 */
+	virtual size_t size() const = 0;
+
+	/**
+	 * Compute the tasks first..last-1 in the given worker thread.
+	 */
+	virtual void compute(relatedness_worker& worker, size_t first, size_t last) = 0;
+
+	/**
+	 * Called by the pool before the first task is handed out resp. after the batch has been
+	 * completed.
+	 */
+	virtual void submitted(relatedness_threadpool&) {};
+	virtual void completed(relatedness_threadpool&) {};
+      };
+
+
       // internal structure used by RelatednessWorker to represent "jobs"
       struct rtask {
-	const char* from;   // the URI from which to start
-	const char* to;     // the URI where to end
-	int fromId, toId;   // node ids in the disambiguation graph
+	int from, to;       // vertice ids in the knowledge graph where to start and end
 	double relatedness; // computation result
+	bool computed;      // false if the deadline of the batch passed before the task was computed
+      };
+
+      // an edge of the disambiguation graph and the task computing its weight
+      struct redge {
+	int fromId, toId;   // node ids in the disambiguation graph
+	size_t task;        // index of the task in the batch
+      };
+
+
+      /**
+       * The relatedness tasks of a single request together with the algorithm configuration. The
+       * result of each task is stored in its relatedness field (DBL_MAX if not related).
+       */
+      class relatedness_batch : public pool_batch {
+
+	friend class relatedness_worker;
+
+	DisambiguationRequest::RelatednessAlgorithm algorithm;
+	int    max_dist;
+	double cutoff;    // relatedness values above the cutoff add no edge
+	bool   symmetric; // the algorithm gives the same result in both directions
+	bool   cached;    // results are looked up in / added to the relatedness cache of the pool
+	bool   merged;    // searches from the same source are merged across requests
+
+	std::vector<rtask>  tasks;
+	std::vector<redge>  edges;
+
+	// index of the task for each pair of vertices (from in the upper, to in the lower 32 bits)
+	std::unordered_map<uint64_t, size_t> pairs;
+
+	// pairs registered as pending with the flights of the pool
+	std::vector<std::pair<int,int> >     pending;
+
+	// compute the tasks with the given indexes, all starting at the same source, coalesced with
+	// the computations of other requests
+	void compute_source(relatedness_worker& worker, int source, std::vector<size_t>& group);
+
+      public:
+
+	relatedness_batch(DisambiguationRequest::RelatednessAlgorithm algorithm, int max_dist, double cutoff);
+
+	/**
+	 * True if the algorithm gives the same relatedness in both directions.
+	 */
+	static bool is_symmetric(DisambiguationRequest::RelatednessAlgorithm algorithm);
+
+	/**
+	 * Request the relatedness between the knowledge graph vertices from and to as weight of the
+	 * edge fromId -> toId in the disambiguation graph. A task is only created if the pair has
+	 * not been requested before.
+	 */
+	void add_task(int from, int to, int fromId, int toId);
+
+	/**
+	 * Request the relatedness between the knowledge graph vertices from and to without adding
+	 * an edge (e.g. to compute the relatedness for several requests at once). Returns the index
+	 * of the task.
+	 */
+	size_t add_pair(int from, int to);
+
+	/**
+	 * Look up the relatedness between the vertices from and to in the (completed) batch. Returns
+	 * false if the pair is not part of the batch or has not been computed.
+	 */
+	bool lookup(int from, int to, double* relatedness) const;
+
+	inline size_t size() const { return tasks.size(); };
+
+	inline const rtask& get_task(size_t k) const { return tasks[k]; };
+
+	inline size_t num_edges() const { return edges.size(); };
+
+	inline const redge& get_edge(size_t e) const { return edges[e]; };
+
+	// relatedness computed for the edge e (once the batch is completed)
+	inline double get_relatedness(size_t e) const { return tasks[edges[e].task].relatedness; };
+
+	// false if the relatedness of edge e was not computed before the deadline
+	inline bool is_computed(size_t e) const { return tasks[edges[e].task].computed; };
+
+	/**
+	 * Compute the relatedness of the given tasks; once fewer tasks than threads remain, shortest
+	 * path tasks with a large maximum distance are computed by the parallel algorithm of the pool.
+	 */
+	void compute(relatedness_worker& worker, size_t first, size_t last);
+
+	/**
+	 * Register the pairs of the batch as pending with the pool, so that searches of concurrent
+	 * requests from the same sources compute them as well (and remove them afterwards).
+	 */
+	void submitted(relatedness_threadpool& pool);
+	void completed(relatedness_threadpool& pool);
+
+	/**
+	 * Add every requested edge whose task is related to the WSD graph, with the relatedness as
+	 * weight, using a single bulk insertion. Edges not computed before the deadline are left out.
+	 */
+	void add_edges(igraph_t* wsd_graph, igraph_vector_t* wsd_weights) const;
       };
 
-      class relatedness_threadpool_base;
+
+      class relatedness_threadpool;
 
       /**
-       * A relatedness worker is a thread initialised with a number of relatedness computation tasks
-       * that are executed in order once the thread is started
+       * A relatedness worker is a thread of the pool computing relatedness tasks of the submitted
+       * batches until the pool is shut down.
        */
       class relatedness_worker : public virtual mico::threading::thread {
 
+	friend class relatedness_batch;
+
       private:
 	int id;
 
-	relatedness_threadpool_base* pool;
+	relatedness_threadpool* pool;
+
+	// algorithm instances used by this worker so far, by algorithm type
+	std::map<int, mico::relatedness::base*> states;
+
+	// return the (cached) instance of the given algorithm configured for the given batch
+	mico::relatedness::base* state(const relatedness_batch& batch);
+
+	// take chunks of tasks from the batch and compute them until there are no more tasks
+	void process(pool_batch& batch);
+
+	// try to reserve the parallel algorithm of the pool for a task of the batch
+	bool claim_parallel(const relatedness_batch& batch);
+
+	// compute a relatedness value with the (claimed) parallel algorithm and release it
+	double parallel_relatedness(int from, int to);
 
       public:
 
-	relatedness_worker(int id, relatedness_threadpool_base* pool) 
+	relatedness_worker(int id, relatedness_threadpool* pool)
 	  : mico::threading::thread(), id(id), pool(pool) {};
 
+	~relatedness_worker();
+
+	/**
+	 * Number of the worker in the pool (0..NUM_THREADS-1), e.g. for per-thread accumulators.
+	 */
+	inline int get_id() const { return id; };
 
 	/**
-         * Process all tasks. When finished, write results into the wsd_graph and wsd_weights using
-         * a shared lock.
+         * Process tasks of the submitted batches and store the results in the tasks.
          */
 	void run();
 
 
       };
 
-      class relatedness_threadpool_base {
-	
+
+      class relatedness_threadpool {
+
 	// workers can access the pool fields
 	friend class relatedness_worker;
+	friend class relatedness_batch;
 
       protected:
-	bool initialised;
 
 	// the workers used by the pool
 	relatedness_worker*      pool[NUM_THREADS];
-	
-	// the worker states used by the pool
-	mico::relatedness::base* states[NUM_THREADS];
 
-	std::queue<rtask>        tasks;
+	// batches with tasks that have not yet been handed out, in order of submission
+	std::list<pool_batch*> batches;
 
-	// the knowledge graph in the backend
-	mico::graph::rgraph_complete*   graph;         
+	// relatedness values of previous requests
+	relatedness_cache        cache;
 
-	// the WSD data structures
-	igraph_t&         wsd_graph;
-	igraph_vector_t&  wsd_weights;
-	pthread_mutex_t   wsd_mutex;      /* graph mutex  */
-	pthread_mutex_t   tsk_mutex;      /* queue mutex  */
+	// relatedness computations in progress
+	relatedness_flights      flights;
 
-	// algorithm configuration
-	int max_dist;
+	// parallel shortest path for the tail of a batch (NULL until first needed)
+	mico::relatedness::delta_stepping* parallel;
+	unsigned                 parallel_searches; // number of parallel searches claimed so far
+	bool                     parallel_busy;     // a parallel search is in progress
 
-	// abstract method for creating the algorithm states
-	virtual mico::relatedness::base* create_algorithm() = 0;
+	bool                     shutdown;
 
+	// the knowledge graph in the backend
+	mico::graph::rgraph_complete*   graph;
+
+	pthread_mutex_t   tsk_mutex;      /* queue mutex  */
+	pthread_cond_t    tsk_cond;       /* signalled when there is new work or a task has been completed */
+	pthread_cond_t    done_cond;      /* signalled when a batch has been completed */
 
       public:
 
-	relatedness_threadpool_base(mico::graph::rgraph_complete* graph, igraph_t& wsd_graph, igraph_vector_t& wsd_weights, int max_dist);
-	~relatedness_threadpool_base();
+	/**
+	 * Create a thread pool for computing relatedness over the given graph and start its workers.
+	 */
+	relatedness_threadpool(mico::graph::rgraph_complete* graph);
 
-	// add a relatedness task to the queue
-	inline void add_task(rtask t) {
-	  tasks.push(t);
-	};
+	/**
+	 * Stop all workers and release their algorithm states.
+	 */
+	~relatedness_threadpool();
+
+	/**
+	 * Compute all tasks of the batch in the worker threads and wait for their completion. Can be
+	 * called by several threads concurrently.
+	 */
+	void execute(pool_batch& batch);
 
-	// reset all workers to initial state
-	void reset();
+	/**
+	 * The relatedness cache of the pool (e.g. for reporting hit and miss statistics).
+	 */
+	inline const relatedness_cache& get_cache() const { return cache; };
+
+	/**
+	 * The coalescing of concurrent computations (e.g. for reporting statistics).
+	 */
+	inline const relatedness_flights& get_flights() const { return flights; };
 
-	// start all worker threads
-	void start();
+	/**
+	 * Number of batches waiting in the queue, i.e. whose tasks have not all been handed out to
+	 * the workers (the input of the load controller).
+	 */
+	size_t backlog();
 
-	// wait for completion of all worker threads
-	void join();
+	/**
+	 * Back the relatedness cache with precomputed values (see relatedness_cache::attach).
+	 */
+	inline void attach(const mico::graph::relatedness_table* table) { cache.attach(table); };
       };
 
 
       /**
-       * Templated relatedness_threadpool for algorithms with a constructor of the form 
-       * C(rgraph* g, int max_dist)
+       * Create a new instance of the given relatedness algorithm over the graph.
        */
-      template <class A> class relatedness_threadpool : public virtual relatedness_threadpool_base {
-      private:
-
-	mico::relatedness::base* create_algorithm() {
-	  return new A(graph,max_dist);
-	};
-	
-
-      public:
-
-	relatedness_threadpool(mico::graph::rgraph_complete* graph, igraph_t& wsd_graph, igraph_vector_t& wsd_weights, int max_dist) 
-	  : relatedness_threadpool_base(graph, wsd_graph, wsd_weights, max_dist) {};
-
-      };
+      mico::relatedness::base* create_algorithm(DisambiguationRequest::RelatednessAlgorithm algorithm, mico::graph::rgraph_complete* graph, int max_dist);
 
     }
 
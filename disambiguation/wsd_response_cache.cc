@@ -0,0 +1,252 @@
+#include <string.h>
+
+#include <algorithm>
+
+#include "wsd_response_cache.h"
+#include "../graph/hash.h"
+#include "../config.h"
+
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      response_cache::response_cache(size_t bytes) : shards(NULL), sets(0), budget(0), max_response(0) {
+	if(bytes == 0) {
+	  return;
+	}
+
+	// one entry for every RESPONSE_CACHE_SLOT bytes, so that small responses can use the memory
+	sets = bytes / ((size_t)RESPONSE_CACHE_SLOT * RESPONSE_CACHE_SHARDS * RESPONSE_CACHE_WAYS);
+	if(sets < 1) {
+	  sets = 1;
+	}
+	budget       = bytes / RESPONSE_CACHE_SHARDS;
+	max_response = std::min((size_t)RESPONSE_CACHE_MAX_RESPONSE, budget);
+
+	shards = new shard[RESPONSE_CACHE_SHARDS];
+	for(int i=0; i<RESPONSE_CACHE_SHARDS; i++) {
+	  pthread_mutex_init(&shards[i].mutex,NULL);
+	  shards[i].entries = new entry[sets * RESPONSE_CACHE_WAYS];
+	  for(size_t j=0; j<sets * RESPONSE_CACHE_WAYS; j++) {
+	    shards[i].entries[j].used       = false;
+	    shards[i].entries[j].referenced = false;
+	  }
+	  shards[i].hand      = 0;
+	  shards[i].sweep     = 0;
+	  shards[i].bytes     = 0;
+	  shards[i].hits      = 0;
+	  shards[i].misses    = 0;
+	  shards[i].evictions = 0;
+	}
+      }
+
+      response_cache::~response_cache() {
+	if(shards == NULL) {
+	  return;
+	}
+	for(int i=0; i<RESPONSE_CACHE_SHARDS; i++) {
+	  pthread_mutex_destroy(&shards[i].mutex);
+	  delete[] shards[i].entries;
+	}
+	delete[] shards;
+      }
+
+
+      response_cache::shard* response_cache::locate(const key& fingerprint, entry** set) const {
+	shard* s = &shards[fingerprint.lo % RESPONSE_CACHE_SHARDS];
+
+	*set = s->entries + ((fingerprint.lo / RESPONSE_CACHE_SHARDS) % sets) * RESPONSE_CACHE_WAYS;
+	return s;
+      }
+
+
+      void response_cache::release(shard* s, entry* e) {
+	s->bytes -= e->confidences.size() * sizeof(double);
+	std::vector<double>().swap(e->confidences);
+	e->used       = false;
+	e->referenced = false;
+      }
+
+
+      void response_cache::reclaim(shard* s, const entry* keep, size_t size) {
+	size_t n = sets * RESPONSE_CACHE_WAYS;
+
+	// CLOCK over the whole shard: the second pass evicts the entries whose bit was cleared
+	// in the first one, so the loop ends as long as size <= budget
+	while(s->bytes + size > budget) {
+	  entry& e = s->entries[s->sweep];
+	  s->sweep = (s->sweep + 1) % n;
+	  if(!e.used || &e == keep) {
+	    continue;
+	  }
+	  if(e.referenced) {
+	    e.referenced = false;
+	  } else {
+	    release(s, &e);
+	    s->evictions.fetch_add(1, std::memory_order_relaxed);
+	  }
+	}
+      }
+
+
+      response_cache::key response_cache::fingerprint(const std::string& canonical) {
+	using mico::graph::rotl64;
+	using mico::graph::mix64;
+
+	const uint64_t c1 = 0x87c37b91114253d5ULL;
+	const uint64_t c2 = 0x4cf5ad432745937fULL;
+	const uint8_t* data = (const uint8_t*)canonical.data();
+	size_t         len  = canonical.size();
+	uint64_t       h1 = 0, h2 = 0, k1, k2;
+	size_t         i;
+
+	// body: blocks of 16 bytes
+	for(i = 0; i + 16 <= len; i += 16) {
+	  memcpy(&k1, data + i, 8);
+	  memcpy(&k2, data + i + 8, 8);
+
+	  k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+	  h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+	  k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+	  h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+	}
+
+	// tail: the remaining 0..15 bytes
+	k1 = 0;
+	k2 = 0;
+	for(size_t j = len - i; j > 0; j--) {
+	  if(j > 8) {
+	    k2 ^= (uint64_t)data[i + j - 1] << (8 * (j - 9));
+	  } else {
+	    k1 ^= (uint64_t)data[i + j - 1] << (8 * (j - 1));
+	  }
+	}
+	k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+	k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+
+	// finalization
+	h1 ^= len;
+	h2 ^= len;
+	h1 += h2;
+	h2 += h1;
+	h1 = mix64(h1);
+	h2 = mix64(h2);
+	h1 += h2;
+	h2 += h1;
+
+	key k;
+	k.hi = h1;
+	k.lo = h2;
+	return k;
+      }
+
+
+      bool response_cache::lookup(const key& fingerprint, std::vector<double>& confidences) {
+	if(sets == 0) {
+	  return false;
+	}
+
+	entry* set;
+	shard* s = locate(fingerprint, &set);
+	bool   found = false;
+
+	pthread_mutex_lock(&s->mutex);
+	for(int i=0; i<RESPONSE_CACHE_WAYS; i++) {
+	  if(set[i].used && set[i].fingerprint == fingerprint) {
+	    confidences = set[i].confidences;
+	    set[i].referenced = true;
+	    found = true;
+	    break;
+	  }
+	}
+	pthread_mutex_unlock(&s->mutex);
+
+	if(found) {
+	  s->hits.fetch_add(1, std::memory_order_relaxed);
+	} else {
+	  s->misses.fetch_add(1, std::memory_order_relaxed);
+	}
+	return found;
+      }
+
+
+      void response_cache::insert(const key& fingerprint, const std::vector<double>& confidences) {
+	size_t size = confidences.size() * sizeof(double);
+	if(sets == 0 || size > max_response) {
+	  return;
+	}
+
+	entry* set;
+	shard* s = locate(fingerprint, &set);
+	entry* slot = NULL;
+	int    i;
+
+	pthread_mutex_lock(&s->mutex);
+
+	// replace the existing entry of the key, or take an empty one
+	for(i=0; i<RESPONSE_CACHE_WAYS && slot == NULL; i++) {
+	  if(set[i].used && set[i].fingerprint == fingerprint) {
+	    slot = &set[i];
+	    release(s, slot);
+	  }
+	}
+	for(i=0; i<RESPONSE_CACHE_WAYS && slot == NULL; i++) {
+	  if(!set[i].used) {
+	    slot = &set[i];
+	  }
+	}
+
+	// CLOCK: advance the hand until an entry without reference bit is found
+	while(slot == NULL) {
+	  entry& e = set[s->hand];
+	  s->hand = (s->hand + 1) % RESPONSE_CACHE_WAYS;
+	  if(e.referenced) {
+	    e.referenced = false;
+	  } else {
+	    slot = &e;
+	    release(s, slot);
+	    s->evictions.fetch_add(1, std::memory_order_relaxed);
+	  }
+	}
+
+	// make room in the memory of the shard
+	reclaim(s, slot, size);
+
+	std::vector<double>(confidences).swap(slot->confidences);
+	slot->fingerprint = fingerprint;
+	slot->used        = true;
+	slot->referenced  = false;
+	s->bytes         += size;
+
+	pthread_mutex_unlock(&s->mutex);
+      }
+
+
+      uint64_t response_cache::hits() const {
+	uint64_t n = 0;
+	for(int i=0; sets > 0 && i<RESPONSE_CACHE_SHARDS; i++) {
+	  n += shards[i].hits.load(std::memory_order_relaxed);
+	}
+	return n;
+      }
+
+      uint64_t response_cache::misses() const {
+	uint64_t n = 0;
+	for(int i=0; sets > 0 && i<RESPONSE_CACHE_SHARDS; i++) {
+	  n += shards[i].misses.load(std::memory_order_relaxed);
+	}
+	return n;
+      }
+
+      uint64_t response_cache::evictions() const {
+	uint64_t n = 0;
+	for(int i=0; sets > 0 && i<RESPONSE_CACHE_SHARDS; i++) {
+	  n += shards[i].evictions.load(std::memory_order_relaxed);
+	}
+	return n;
+      }
+
+    }
+  }
+}
@@ -0,0 +1,116 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_RESPONSE_CACHE_H
+#define HAVE_RESPONSE_CACHE_H 1
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+
+/**
+ * A cache of whole responses. Batch re-processing jobs send the same requests again and again,
+ * often with the entities or candidates in a different order; such requests are answered from the
+ * cache before any work on the graph is done.
+ *
+ * Requests are keyed by a 128 bit fingerprint of their canonical form: all fields that influence
+ * the confidences (candidates, algorithms and their parameters), with the candidates of every
+ * entity in sorted order (see WSDDisambiguationRequest). The cache stores the confidences of the
+ * candidates in canonical order. This is only sound because the results of a disambiguation are
+ * deterministic (see centrality_graph); requests with a deadline are never cached.
+ *
+ * Like the relatedness cache, the cache is divided into RESPONSE_CACHE_SHARDS shards with their
+ * own lock, and each key can be stored in one of RESPONSE_CACHE_WAYS entries of its set; full sets
+ * evict an entry using the CLOCK algorithm. Since responses differ in size, the memory of the
+ * cache is bounded in bytes: every shard has an equal share of it, and when a new response does
+ * not fit, a second clock hand passing over all entries of the shard evicts responses until it
+ * does. Responses larger than RESPONSE_CACHE_MAX_RESPONSE bytes are not cached.
+ */
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      class response_cache {
+
+      public:
+
+	// 128 bit fingerprint of a canonical request
+	struct key {
+	  uint64_t hi, lo;
+
+	  inline bool operator==(const key& o) const { return hi == o.hi && lo == o.lo; };
+	};
+
+      private:
+
+	struct entry {
+	  key                 fingerprint;
+	  bool                used;
+	  bool                referenced;   // CLOCK reference bit
+	  std::vector<double> confidences;  // in canonical order of the candidates
+	};
+
+	struct shard {
+	  pthread_mutex_t       mutex;
+	  entry*                entries;
+	  unsigned              hand;       // CLOCK hand, position within a set
+	  size_t                sweep;      // CLOCK hand over all entries, for freeing memory
+	  size_t                bytes;      // memory of the stored confidences
+	  std::atomic<uint64_t> hits, misses, evictions;
+	};
+
+	shard* shards;
+	size_t sets;           // number of sets per shard (0 if the cache is disabled)
+	size_t budget;         // bytes of confidences per shard
+	size_t max_response;   // bytes of the largest response that is cached
+
+	// return the shard of the key and the first entry of its set
+	shard* locate(const key& fingerprint, entry** set) const;
+
+	// drop the response of the entry (called with the mutex of the shard held)
+	static void release(shard* s, entry* e);
+
+	// evict responses of the shard other than keep until size more bytes fit into its budget
+	// (called with the mutex of the shard held)
+	void reclaim(shard* s, const entry* keep, size_t size);
+
+      public:
+
+	/**
+	 * Create a cache using (about) the given number of bytes; 0 disables the cache.
+	 */
+	response_cache(size_t bytes);
+
+	~response_cache();
+
+	inline bool enabled() const { return sets > 0; };
+
+	/**
+	 * Compute the fingerprint of the canonical form of a request (MurmurHash3, x64 128 bit).
+	 */
+	static key fingerprint(const std::string& canonical);
+
+	/**
+	 * Look up the confidences of the request with the given fingerprint. Returns false if the
+	 * cache does not contain the request.
+	 */
+	bool lookup(const key& fingerprint, std::vector<double>& confidences);
+
+	/**
+	 * Store the confidences of the request with the given fingerprint.
+	 */
+	void insert(const key& fingerprint, const std::vector<double>& confidences);
+
+	/**
+	 * Number of successful and failed lookups and of evicted entries since the cache was created.
+	 */
+	uint64_t hits() const;
+	uint64_t misses() const;
+	uint64_t evictions() const;
+      };
+
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,34 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_SERVICES_H
+#define HAVE_SERVICES_H 1
+
+#include <stddef.h>
+
+#include "wsd_sessions.h"
+#include "wsd_response_cache.h"
+#include "wsd_relatedness_costs.h"
+#include "wsd_load.h"
+
+/**
+ * Server-wide state shared by all requests besides the relatedness thread pool. The objects are
+ * owned by the server (see wsd-disambiguation.cc) and outlive all requests; a service that is
+ * NULL is not used.
+ */
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      struct services {
+	session_store*     sessions;    // incremental requests (NULL: session ids are ignored)
+	response_cache*    responses;   // confidences of previous requests (NULL: no caching)
+	relatedness_costs* costs;       // cost model for AUTO relatedness (NULL: AUTO uses PARTITION)
+	load_controller*   load;        // degradation under load (NULL: all requests are computed as requested)
+
+	services() : sessions(NULL), responses(NULL), costs(NULL), load(NULL) {};
+      };
+
+    }
+  }
+}
+
+#endif
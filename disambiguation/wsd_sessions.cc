@@ -0,0 +1,141 @@
+#include "wsd_sessions.h"
+#include "../graph/relatedness_table.h"
+
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      // seconds of the monotonic clock
+      static inline time_t now() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec;
+      }
+
+
+      session::session() : users(0), expires(0), config(0), cutoff(0.0) {
+	pthread_mutex_init(&mutex,NULL);
+      }
+
+      session::~session() {
+	pthread_mutex_destroy(&mutex);
+      }
+
+      void session::use(uint32_t config, double cutoff) {
+	if(this->config != config || this->cutoff != cutoff) {
+	  values.clear();
+	  this->config = config;
+	  this->cutoff = cutoff;
+	}
+      }
+
+      bool session::lookup(int from, int to, double* relatedness) const {
+	std::unordered_map<uint64_t, double>::const_iterator it = values.find(mico::graph::relatedness_table::pair(from, to));
+	if(it == values.end()) {
+	  return false;
+	}
+	*relatedness = it->second;
+	return true;
+      }
+
+
+      session_store::session_store(int ttl, size_t capacity) : ttl(ttl), capacity(capacity), swept(0), num_reused(0), num_computed(0) {
+	pthread_mutex_init(&mutex,NULL);
+      }
+
+      session_store::~session_store() {
+	for(std::unordered_map<std::string, session*>::iterator it = sessions.begin(); it != sessions.end(); ++it) {
+	  delete it->second;
+	}
+	pthread_mutex_destroy(&mutex);
+      }
+
+
+      void session_store::remove(session* s) {
+	sessions.erase(s->id);
+	recent.erase(s->recent);
+	delete s;
+      }
+
+
+      void session_store::sweep(time_t t) {
+	std::list<session*>::iterator it = recent.begin();
+	while(it != recent.end()) {
+	  session* s = *it++;
+	  if(s->users == 0 && s->expires <= t) {
+	    remove(s);
+	  }
+	}
+	swept = t;
+      }
+
+
+      void session_store::evict() {
+	std::list<session*>::iterator it = recent.end();
+	while(sessions.size() > capacity && it != recent.begin()) {
+	  session* s = *--it;
+	  if(s->users == 0) {
+	    it = recent.erase(it);
+	    sessions.erase(s->id);
+	    delete s;
+	  }
+	}
+      }
+
+
+      session* session_store::acquire(const std::string& id) {
+	time_t   t = now();
+	session* s;
+
+	pthread_mutex_lock(&mutex);
+	// at most once a second, so the store is not scanned by every request
+	if(t != swept) {
+	  sweep(t);
+	}
+	s = sessions[id];
+	if(s == NULL) {
+	  s = sessions[id] = new session();
+	  s->id = id;
+	  s->recent = recent.insert(recent.begin(), s);
+	} else {
+	  recent.splice(recent.begin(), recent, s->recent);
+	}
+	s->users++;
+	evict();
+	pthread_mutex_unlock(&mutex);
+
+	// requests of the same session are processed one after the other
+	pthread_mutex_lock(&s->mutex);
+
+	if(s->expires <= t) {
+	  s->vertices.clear();
+	  s->values.clear();
+	  s->config = 0;
+	}
+	return s;
+      }
+
+
+      void session_store::release(session* s, uint64_t reused, uint64_t computed) {
+	num_reused.fetch_add(reused, std::memory_order_relaxed);
+	num_computed.fetch_add(computed, std::memory_order_relaxed);
+
+	pthread_mutex_lock(&mutex);
+	s->expires = now() + ttl;
+	s->users--;
+	pthread_mutex_unlock(&s->mutex);
+	pthread_mutex_unlock(&mutex);
+      }
+
+
+      size_t session_store::size() {
+	size_t n;
+	pthread_mutex_lock(&mutex);
+	n = sessions.size();
+	pthread_mutex_unlock(&mutex);
+	return n;
+      }
+
+    }
+  }
+}
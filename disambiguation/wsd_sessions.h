@@ -0,0 +1,123 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_SESSIONS_H
+#define HAVE_SESSIONS_H 1
+
+#include <atomic>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+/**
+ * Sessions for incremental disambiguation. Interactive clients (e.g. an editor) send the whole
+ * document again after every change of a single entity; with a session id in the request, the
+ * server keeps the resolved candidates and the relatedness values of the candidate pairs of the
+ * previous request of the session, so only the pairs involving new or changed candidates are
+ * computed again before the centrality is recomputed.
+ *
+ * A session stays alive for SESSION_TTL seconds after its last request; beyond SESSION_MAX live
+ * sessions, the least recently used ones that are not in use are dropped. The values of a session
+ * are only valid for one relatedness configuration (algorithm, maximum distance and cutoff); a
+ * request with a different configuration starts the session over.
+ */
+namespace mico {
+  namespace disambiguation {
+    namespace wsd {
+
+      class session {
+
+	friend class session_store;
+
+	pthread_mutex_t mutex;      // held while a request of the session is processed
+	int             users;      // requests holding or waiting for the session (store mutex)
+	time_t          expires;
+
+	std::string                   id;
+	std::list<session*>::iterator recent;   // position in the LRU list of the store
+
+	uint32_t        config;     // relatedness configuration of the values
+	double          cutoff;
+
+      public:
+
+	// candidate URIs of the previous request resolved to vertice ids
+	std::unordered_map<std::string, int> vertices;
+
+	// relatedness of the candidate pairs of the previous request
+	std::unordered_map<uint64_t, double> values;
+
+	session();
+	~session();
+
+	/**
+	 * Use the session for a request with the given relatedness configuration and cutoff; the
+	 * values of the session are discarded if they were computed with a different one.
+	 */
+	void use(uint32_t config, double cutoff);
+
+	/**
+	 * Look up the relatedness of the pair from, to. Returns false if the previous request did
+	 * not have the pair.
+	 */
+	bool lookup(int from, int to, double* relatedness) const;
+      };
+
+
+      class session_store {
+
+	pthread_mutex_t mutex;
+	std::unordered_map<std::string, session*> sessions;
+	std::list<session*>                       recent;    // most recently used first
+
+	int                   ttl;
+	size_t                capacity;
+	time_t                swept;     // last time expired sessions were removed
+
+	std::atomic<uint64_t> num_reused, num_computed;
+
+	// remove the session from the store (called with the mutex held)
+	void remove(session* s);
+
+	// remove the sessions that expired and are not in use (called with the mutex held)
+	void sweep(time_t now);
+
+	// remove the least recently used sessions not in use while there are more than capacity
+	// (called with the mutex held)
+	void evict();
+
+      public:
+
+	session_store(int ttl, size_t capacity);
+	~session_store();
+
+	/**
+	 * Return the session with the given id for exclusive use by a request, creating it if it
+	 * does not exist (yet or any more).
+	 */
+	session* acquire(const std::string& id);
+
+	/**
+	 * Give the session back after the request has replaced its vertices and values, counting
+	 * the number of relatedness values the request took from the session and computed anew.
+	 */
+	void release(session* s, uint64_t reused, uint64_t computed);
+
+	/**
+	 * Number of live sessions.
+	 */
+	size_t size();
+
+	/**
+	 * Number of relatedness values taken from sessions and computed for requests with a session.
+	 */
+	inline uint64_t reused() const { return num_reused.load(std::memory_order_relaxed); };
+	inline uint64_t computed() const { return num_computed.load(std::memory_order_relaxed); };
+      };
+
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,122 @@
+#include <iostream>
+#include <string.h>
+
+#include "rgraph.h"
+#include "adjacency.h"
+
+
+namespace mico {
+  namespace graph {
+
+    /**
+     * Merge the (sorted) outgoing and incoming neighbor lists of a vertice, skipping duplicates
+     * and self loops. If out is NULL, only count the number of distinct neighbors.
+     */
+    static long int merge_neighbors(igraph_t* g, long int node, uint32_t* out) {
+      long int i, j, ie, je, n = 0;
+      uint32_t v, w, last = 0;
+      bool first = true;
+
+      // igraph keeps the edge indexes ordered by (from,to) resp. (to,from), so both lists are
+      // already sorted by neighbor id
+      i  = (long int) VECTOR(g->os)[node];
+      ie = (long int) VECTOR(g->os)[node+1];
+      j  = (long int) VECTOR(g->is)[node];
+      je = (long int) VECTOR(g->is)[node+1];
+
+      while(i < ie || j < je) {
+	if(j >= je) {
+	  v = VECTOR(g->to)[(long int)VECTOR(g->oi)[i++]];
+	} else if(i >= ie) {
+	  v = VECTOR(g->from)[(long int)VECTOR(g->ii)[j++]];
+	} else {
+	  v = VECTOR(g->to)[(long int)VECTOR(g->oi)[i]];
+	  w = VECTOR(g->from)[(long int)VECTOR(g->ii)[j]];
+	  if(v <= w) {
+	    i++;
+	  } else {
+	    v = w;
+	    j++;
+	  }
+	}
+
+	if(v != node && (first || v != last)) {
+	  if(out) {
+	    out[n] = v;
+	  }
+	  n++;
+	  last  = v;
+	  first = false;
+	}
+      }
+      return n;
+    }
+
+
+    adjacency::adjacency(const rgraph& graph) : num_vertices(graph.num_vertices), num_hubs(0) {
+      long int node;
+
+      std::cout << "- building neighborhood adjacency for " << num_vertices << " vertices ... ";
+      std::cout.flush();
+
+      // 1. count distinct neighbors to compute offsets
+      offsets = new long int[num_vertices + 1];
+      offsets[0] = 0;
+      for(node=0; node<num_vertices; node++) {
+	offsets[node+1] = offsets[node] + merge_neighbors(graph.graph, node, NULL);
+      }
+
+      // 2. fill neighbor lists
+      targets = new uint32_t[offsets[num_vertices] > 0 ? offsets[num_vertices] : 1];
+      for(node=0; node<num_vertices; node++) {
+	merge_neighbors(graph.graph, node, targets + offsets[node]);
+      }
+
+      // 3. precompute bitmaps for high-degree vertices
+      hub_index = new int[num_vertices];
+      for(node=0; node<num_vertices; node++) {
+	hub_index[node] = degree(node) >= NEIGHBORHOOD_HUB_DEGREE ? num_hubs++ : -1;
+      }
+
+      hub_bitmaps = new uint64_t[(long int)num_hubs * NEIGHBORHOOD_WORDS + 1];
+      memset(hub_bitmaps, 0, ((long int)num_hubs * NEIGHBORHOOD_WORDS + 1) * sizeof(uint64_t));
+      for(node=0; node<num_vertices; node++) {
+	if(hub_index[node] >= 0) {
+	  uint64_t* b = hub_bitmaps + (long int)hub_index[node] * NEIGHBORHOOD_WORDS;
+	  const uint32_t* n = neighbors(node);
+	  for(int k=0; k<degree(node); k++) {
+	    b[bit(n[k]) >> 6] |= 1ULL << (bit(n[k]) & 63);
+	  }
+	  b[bit(node) >> 6] |= 1ULL << (bit(node) & 63);
+	}
+      }
+
+      std::cout << offsets[num_vertices] << " entries, " << num_hubs << " hubs!\n";
+    }
+
+
+    adjacency::~adjacency() {
+      delete[] offsets;
+      delete[] targets;
+      delete[] hub_index;
+      delete[] hub_bitmaps;
+    }
+
+
+    void adjacency::add_neighborhood(int v, uint64_t* bitmap) const {
+      const uint64_t* b = this->bitmap(v);
+      if(b != NULL) {
+	for(int k=0; k<NEIGHBORHOOD_WORDS; k++) {
+	  bitmap[k] |= b[k];
+	}
+      } else {
+	const uint32_t* n = neighbors(v);
+	for(int k=0; k<degree(v); k++) {
+	  bitmap[bit(n[k]) >> 6] |= 1ULL << (bit(n[k]) & 63);
+	}
+	bitmap[bit(v) >> 6] |= 1ULL << (bit(v) & 63);
+      }
+    }
+
+  }
+}
@@ -0,0 +1,81 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_ADJACENCY_H
+#define HAVE_ADJACENCY_H 1
+
+#include <stdint.h>
+
+#include "../config.h"
+
+namespace mico {
+  namespace graph {
+
+    class rgraph;
+
+    /**
+     * Compact undirected adjacency representation of an rgraph. For each vertice, the ids of all
+     * vertices connected to it by an incoming or outgoing edge are stored as a sorted list of 32bit
+     * integers without duplicates and self loops, so that neighborhoods can be compared with fast
+     * merge-based set intersections.
+     *
+     * For vertices with a degree of at least NEIGHBORHOOD_HUB_DEGREE, the adjacency additionally
+     * keeps a precomputed bitmap sketch (NEIGHBORHOOD_BITS bits) of the neighbor set including the
+     * vertice itself, so that multi-hop neighborhoods can be approximated without iterating over
+     * the (long) neighbor lists of hubs.
+     *
+     * The structure is derived from the igraph edge indexes and never written to a dump.
+     */
+    class adjacency {
+
+    public:
+      int        num_vertices;  /* number of vertices covered by the adjacency */
+      long int*  offsets;       /* start of the neighbor list of each vertice in targets (num_vertices+1 entries) */
+      uint32_t*  targets;       /* concatenated sorted neighbor lists */
+
+      int*       hub_index;     /* index of each vertice in hub_bitmaps, or -1 if the vertice is no hub */
+      uint64_t*  hub_bitmaps;   /* NEIGHBORHOOD_WORDS words per hub */
+      int        num_hubs;
+
+      /**
+       * Build the adjacency from the igraph edge indexes of the given graph.
+       */
+      adjacency(const rgraph& graph);
+
+      /**
+       * Free all resources claimed by the adjacency.
+       */
+      ~adjacency();
+
+      /**
+       * Number of distinct neighbors of the vertice with the given id.
+       */
+      inline int degree(int v) const { return (int)(offsets[v+1] - offsets[v]); };
+
+      /**
+       * Sorted list of the neighbors of the vertice with the given id (degree(v) entries).
+       */
+      inline const uint32_t* neighbors(int v) const { return targets + offsets[v]; };
+
+      /**
+       * The precomputed bitmap sketch of the neighborhood of v, or NULL if v is not a hub.
+       */
+      inline const uint64_t* bitmap(int v) const {
+	return hub_index[v] >= 0 ? hub_bitmaps + (long int)hub_index[v] * NEIGHBORHOOD_WORDS : NULL;
+      };
+
+      /**
+       * Hash a vertice id into a bit position of a neighborhood bitmap.
+       */
+      static inline uint32_t bit(uint32_t v) {
+	return (v * 2654435761u) >> (32 - NEIGHBORHOOD_BITS_LOG);
+      };
+
+      /**
+       * Add the neighborhood of v (including v itself) to the bitmap given as argument.
+       */
+      void add_neighborhood(int v, uint64_t* bitmap) const;
+    };
+
+  }
+}
+
+#endif
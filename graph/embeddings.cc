@@ -0,0 +1,145 @@
+#include <iostream>
+#include <fstream>
+
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include "embeddings.h"
+#include "../config.h"
+
+#define EMBEDDING_MAGIC   "WSDEMBED"
+#define EMBEDDING_VERSION 2
+
+// size of the norm array in bytes, padded so that the vector array stays aligned
+#define NORMS_LENGTH(n) (((n) * sizeof(float) + 31) / 32 * 32)
+
+namespace mico {
+  namespace graph {
+
+    // binary file header, padded to 32 bytes
+    struct embedding_header {
+      char     magic[8];
+      int32_t  version;
+      int32_t  dim;
+      int32_t  num_vertices;
+      int32_t  reserved;
+      uint64_t fingerprint;
+    };
+
+
+    embeddings::embeddings(int num_vertices, int dim)
+      : mapped(false), map_length(0), map_base(NULL), num_vertices(num_vertices) {
+      this->dim = (dim + EMBEDDING_ALIGN - 1) / EMBEDDING_ALIGN * EMBEDDING_ALIGN;
+
+      norms = new float[num_vertices];
+      data  = new int8_t[(long int)num_vertices * this->dim];
+
+      memset(norms, 0, num_vertices * sizeof(float));
+      memset(data, 0, (long int)num_vertices * this->dim);
+    }
+
+
+    embeddings::~embeddings() {
+      if(mapped) {
+	munmap(map_base, map_length);
+      } else {
+	delete[] norms;
+	delete[] data;
+      }
+    }
+
+
+    void embeddings::set(int v, const float* vector) {
+      int i;
+      float max = 0.0f, norm = 0.0f;
+      int8_t* e = get(v);
+
+      for(i=0; i<dim; i++) {
+	if(fabsf(vector[i]) > max) {
+	  max = fabsf(vector[i]);
+	}
+      }
+
+      for(i=0; i<dim; i++) {
+	e[i]  = max > 0.0f ? (int8_t)lrintf(vector[i] * 127.0f / max) : 0;
+	norm += (float)e[i] * e[i];
+      }
+      norms[v] = sqrtf(norm);
+    }
+
+
+    void embeddings::dump_file(const char* filename, uint64_t fingerprint) const {
+      std::cout << "- dumping embedding data ...\n";
+
+      embedding_header h;
+      memset(&h, 0, sizeof(h));
+      memcpy(h.magic, EMBEDDING_MAGIC, 8);
+      h.version      = EMBEDDING_VERSION;
+      h.dim          = dim;
+      h.num_vertices = num_vertices;
+      h.fingerprint  = fingerprint;
+
+      char pad[32];
+      memset(pad, 0, sizeof(pad));
+
+      std::ofstream os(filename);
+      os.write((char*)&h, sizeof(h));
+      os.write((char*)norms, num_vertices * sizeof(float));
+      os.write(pad, NORMS_LENGTH(num_vertices) - num_vertices * sizeof(float));
+      os.write((char*)data, (long int)num_vertices * dim);
+    }
+
+
+    embeddings* embeddings::map_file(const char* filename, uint64_t fingerprint, int num_vertices) {
+      struct stat buf;
+      embedding_header* h;
+
+      int fd = open(filename, O_RDONLY);
+      if(fd < 0) {
+	return NULL;
+      }
+      if(fstat(fd, &buf) < 0 || (size_t)buf.st_size < sizeof(embedding_header)) {
+	close(fd);
+	return NULL;
+      }
+
+      void* base = mmap(0, buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      close(fd);
+      if(base == MAP_FAILED) {
+	return NULL;
+      }
+
+      h = (embedding_header*)base;
+      if(memcmp(h->magic, EMBEDDING_MAGIC, 8) != 0 || h->version != EMBEDDING_VERSION
+	 || (size_t)buf.st_size < sizeof(embedding_header) + NORMS_LENGTH((size_t)h->num_vertices) + (size_t)h->num_vertices * h->dim) {
+	std::cerr << "invalid embedding file " << filename << ", ignoring\n";
+	munmap(base, buf.st_size);
+	return NULL;
+      }
+      if(h->fingerprint != fingerprint || h->num_vertices != num_vertices) {
+	std::cerr << "embedding file " << filename << " was computed for a different graph, ignoring\n";
+	munmap(base, buf.st_size);
+	return NULL;
+      }
+
+      embeddings* e = new embeddings();
+      e->mapped       = true;
+      e->map_base     = base;
+      e->map_length   = buf.st_size;
+      e->dim          = h->dim;
+      e->num_vertices = h->num_vertices;
+      e->norms        = (float*)((char*)base + sizeof(embedding_header));
+      e->data         = (int8_t*)((char*)base + sizeof(embedding_header) + NORMS_LENGTH((size_t)h->num_vertices));
+
+      std::cout << "- mapped " << e->num_vertices << " vertice embeddings (dimension " << e->dim << ") from " << filename << "\n";
+
+      return e;
+    }
+
+  }
+}
@@ -0,0 +1,75 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_EMBEDDINGS_H
+#define HAVE_EMBEDDINGS_H 1
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace mico {
+  namespace graph {
+
+    /**
+     * Low-dimensional vertice embeddings, quantized to 8bit signed integers. Each vector is
+     * scaled so that its largest component is +/-127; the euclidean norm of the quantized vector
+     * is stored separately so that cosine similarities only need a single dot product.
+     *
+     * Embeddings are stored in a separate file next to the graph dump (<prefix>.embeddings) so
+     * that they can be mapped into memory directly. File format: 32 bytes header (8 bytes magic
+     * "WSDEMBED", 4 bytes version, 4 bytes dimension, 4 bytes number of vertices, 4 bytes
+     * reserved, 8 bytes graph fingerprint), followed by one float norm per vertice (padded to a
+     * multiple of 32 bytes) and the vector array in host byte order. Like sketches, embeddings are
+     * ignored if they were computed for a different graph.
+     */
+    class embeddings {
+
+      bool      mapped;      /* true in case data points into a mapped file */
+      size_t    map_length;  /* length of the mapping (if mapped) */
+      void*     map_base;    /* start of the mapping (if mapped) */
+
+      embeddings() {};
+
+    public:
+      int       dim;          /* dimension of the vectors, always a multiple of EMBEDDING_ALIGN */
+      int       num_vertices; /* number of vectors */
+      float*    norms;        /* euclidean norm of each quantized vector */
+      int8_t*   data;         /* num_vertices * dim vector components */
+
+      /**
+       * Allocate zero embeddings of the given dimension (rounded up to a multiple of
+       * EMBEDDING_ALIGN) for the given number of vertices.
+       */
+      embeddings(int num_vertices, int dim);
+
+      /**
+       * Free or unmap the embedding data.
+       */
+      ~embeddings();
+
+      /**
+       * The embedding vector of the vertice with the given id.
+       */
+      inline int8_t* get(int v) const { return data + (long int)v * dim; };
+
+      /**
+       * Quantize a float vector of length dim into the embedding of vertice v.
+       */
+      void set(int v, const float* vector);
+
+      /**
+       * Write the embeddings of the graph with the given fingerprint to a binary file in the
+       * format described above.
+       */
+      void dump_file(const char* filename, uint64_t fingerprint) const;
+
+      /**
+       * Map the embeddings stored in the given binary file into memory (read only). Returns NULL
+       * in case the file does not exist, is not a valid embedding file or was computed for a
+       * graph with a different fingerprint or number of vertices.
+       */
+      static embeddings* map_file(const char* filename, uint64_t fingerprint, int num_vertices);
+    };
+
+  }
+}
+
+#endif
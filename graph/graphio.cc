@@ -1,9 +1,12 @@
 #include <iostream>
 #include <fstream>
+#include <string>
 
 #include <string.h>
 #include <arpa/inet.h>
 #include "rgraph.h"
+#include "sketches.h"
+#include "embeddings.h"
 
 
 namespace mico {
@@ -74,6 +77,17 @@ namespace mico {
     void rgraph::dump_file(const char* filename) const {
       std::ofstream os(filename);
       dump_stream(os);
+
+      // files derived from the graph record its fingerprint, so they are not used with another graph
+      uint64_t fp = sketch != NULL || embedding != NULL ? fingerprint() : 0;
+
+      if(sketch != NULL && sketch->num_vertices == num_vertices) {
+	sketch->dump_file((std::string(filename) + SKETCH_SUFFIX).c_str(), fp);
+      }
+
+      if(embedding != NULL && embedding->num_vertices == num_vertices) {
+	embedding->dump_file((std::string(filename) + EMBEDDING_SUFFIX).c_str(), fp);
+      }
     }
 
       
@@ -165,6 +179,15 @@ namespace mico {
     void rgraph::restore_file(const char* filename) {
       std::ifstream is(filename);
       restore_stream(is);
+
+      // files derived from the graph are only used if they were computed for this graph
+      uint64_t fp = fingerprint();
+
+      delete sketch;
+      sketch = sketches::map_file((std::string(filename) + SKETCH_SUFFIX).c_str(), fp, num_vertices);
+
+      delete embedding;
+      embedding = embeddings::map_file((std::string(filename) + EMBEDDING_SUFFIX).c_str(), fp, num_vertices);
     }
 
   }
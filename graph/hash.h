@@ -0,0 +1,33 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_HASH_H
+#define HAVE_HASH_H 1
+
+#include <stdint.h>
+
+/**
+ * Building blocks of MurmurHash3 shared by the hash tables and fingerprints of the graph and the
+ * disambiguation server.
+ */
+namespace mico {
+  namespace graph {
+
+    static inline uint64_t rotl64(uint64_t x, int r) {
+      return (x << r) | (x >> (64 - r));
+    }
+
+    /**
+     * 64bit finalizer of MurmurHash3: every bit of h affects every bit of the result.
+     */
+    static inline uint64_t mix64(uint64_t h) {
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return h;
+    }
+
+  }
+}
+
+#endif
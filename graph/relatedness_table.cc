@@ -0,0 +1,122 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <algorithm>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include "relatedness_table.h"
+
+#define RELATEDNESS_MAGIC   "WSDRELAT"
+#define RELATEDNESS_VERSION 1
+
+namespace mico {
+  namespace graph {
+
+    // binary file header, padded to 32 bytes so the records stay aligned
+    struct relatedness_header {
+      char     magic[8];
+      int32_t  version;
+      int32_t  reserved;
+      uint64_t fingerprint;
+      int64_t  size;
+    };
+
+
+    relatedness_table::~relatedness_table() {
+      munmap(map_base, map_length);
+    }
+
+
+    const relatedness_table::record* relatedness_table::find(uint32_t config, uint64_t pair) const {
+      record key;
+      key.pair   = pair;
+      key.config = config;
+
+      const record* r = std::lower_bound(records, records + size, key);
+      if(r != records + size && r->config == config && r->pair == pair) {
+	return r;
+      }
+      return NULL;
+    }
+
+
+    bool relatedness_table::dump_file(const char* filename, uint64_t fingerprint, std::vector<record>& records) {
+      std::cout << "- dumping " << records.size() << " relatedness values ...\n";
+
+      std::sort(records.begin(), records.end());
+
+      relatedness_header h;
+      memset(&h, 0, sizeof(h));
+      memcpy(h.magic, RELATEDNESS_MAGIC, 8);
+      h.version     = RELATEDNESS_VERSION;
+      h.fingerprint = fingerprint;
+      h.size        = records.size();
+
+      std::string tmp = std::string(filename) + ".tmp";
+      std::ofstream os(tmp.c_str());
+      os.write((char*)&h, sizeof(h));
+      os.write((char*)records.data(), records.size() * sizeof(record));
+      os.close();
+
+      if(!os || rename(tmp.c_str(), filename) != 0) {
+	std::cerr << "could not write relatedness file " << filename << "\n";
+	unlink(tmp.c_str());
+	return false;
+      }
+      return true;
+    }
+
+
+    relatedness_table* relatedness_table::map_file(const char* filename, uint64_t fingerprint) {
+      struct stat buf;
+      relatedness_header* h;
+
+      int fd = open(filename, O_RDONLY);
+      if(fd < 0) {
+	return NULL;
+      }
+      if(fstat(fd, &buf) < 0 || (size_t)buf.st_size < sizeof(relatedness_header)) {
+	close(fd);
+	return NULL;
+      }
+
+      void* base = mmap(0, buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      close(fd);
+      if(base == MAP_FAILED) {
+	return NULL;
+      }
+
+      h = (relatedness_header*)base;
+      if(memcmp(h->magic, RELATEDNESS_MAGIC, 8) != 0 || h->version != RELATEDNESS_VERSION || h->size < 0
+	 || (size_t)buf.st_size < sizeof(relatedness_header) + (size_t)h->size * sizeof(record)) {
+	std::cerr << "invalid relatedness file " << filename << ", ignoring\n";
+	munmap(base, buf.st_size);
+	return NULL;
+      }
+      if(h->fingerprint != fingerprint) {
+	std::cerr << "relatedness file " << filename << " was computed for a different graph, ignoring\n";
+	munmap(base, buf.st_size);
+	return NULL;
+      }
+
+      relatedness_table* t = new relatedness_table();
+      t->map_base    = base;
+      t->map_length  = buf.st_size;
+      t->fingerprint = h->fingerprint;
+      t->size        = h->size;
+      t->records     = (record*)((char*)base + sizeof(relatedness_header));
+
+      std::cout << "- mapped " << t->size << " precomputed relatedness values from " << filename << "\n";
+
+      return t;
+    }
+
+  }
+}
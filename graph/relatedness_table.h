@@ -0,0 +1,96 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_RELATEDNESS_TABLE_H
+#define HAVE_RELATEDNESS_TABLE_H 1
+
+#include <vector>
+#include <stdint.h>
+
+namespace mico {
+  namespace graph {
+
+    /**
+     * Precomputed relatedness values of pairs of vertices, stored in a separate file next to the
+     * graph dump (<prefix>.relatedness) so that they survive restarts of the disambiguation
+     * server. The file is written by wsd-create (from a list of pairs) or as a snapshot of the
+     * relatedness cache of a running server, and mapped into memory on startup.
+     *
+     * Values are only valid for the graph they were computed on: the file carries the fingerprint
+     * of the graph (rgraph::fingerprint) and is ignored if it does not match.
+     *
+     * File format: 32 bytes header (8 bytes magic "WSDRELAT", 4 bytes version, 4 bytes reserved, 8
+     * bytes graph fingerprint, 8 bytes number of records), followed by the records sorted by
+     * configuration and pair, in host byte order. Lookups are binary searches on the mapped
+     * records.
+     */
+    class relatedness_table {
+
+    public:
+
+      struct record {
+	uint64_t pair;        // from in the upper, to in the lower 32 bits
+	uint32_t config;      // algorithm and maximum distance (see config())
+	uint32_t reserved;
+	double   relatedness;
+	double   cutoff;      // cutoff the value was computed with
+
+	inline bool operator<(const record& o) const {
+	  return config < o.config || (config == o.config && pair < o.pair);
+	};
+      };
+
+    private:
+
+      size_t    map_length;  /* length of the mapping */
+      void*     map_base;    /* start of the mapping */
+
+      relatedness_table() {};
+
+    public:
+      uint64_t      fingerprint; /* fingerprint of the graph the values were computed on */
+      long          size;        /* number of records */
+      const record* records;     /* records, sorted by config and pair */
+
+      /**
+       * Unmap the file.
+       */
+      ~relatedness_table();
+
+      /**
+       * The key of an algorithm configuration (RelatednessAlgorithm of the disambiguation protocol
+       * and maximum distance).
+       */
+      static inline uint32_t config(int algorithm, int max_dist) {
+	return ((uint32_t)algorithm << 16) | (uint16_t)max_dist;
+      };
+
+      /**
+       * The key of a pair of vertices.
+       */
+      static inline uint64_t pair(int from, int to) {
+	return ((uint64_t)(uint32_t)from << 32) | (uint32_t)to;
+      };
+
+      /**
+       * Find the record of the pair in the given configuration, NULL if there is none.
+       */
+      const record* find(uint32_t config, uint64_t pair) const;
+
+      /**
+       * Sort the records and write them to a binary file in the format described above. The file
+       * is written under a temporary name and then renamed, so that servers having the previous
+       * version mapped are not affected. Returns false if the file could not be written.
+       */
+      static bool dump_file(const char* filename, uint64_t fingerprint, std::vector<record>& records);
+
+      /**
+       * Map the relatedness file into memory (read only). Returns NULL in case the file does not
+       * exist, is not a valid relatedness file or was computed for a graph with a different
+       * fingerprint.
+       */
+      static relatedness_table* map_file(const char* filename, uint64_t fingerprint);
+    };
+
+  }
+}
+
+#endif
@@ -1,4 +1,8 @@
 #include "rgraph.h"
+#include "adjacency.h"
+#include "sketches.h"
+#include "embeddings.h"
+#include "hash.h"
 
 
 namespace mico {
@@ -19,6 +23,11 @@ namespace mico {
 
       num_vertices = 0;
 
+      adj = NULL;
+
+      sketch = NULL;
+      embedding = NULL;
+
       // apply initial sizes
       if(rv > 0)
 	reserve_vertices(rv);
@@ -60,6 +69,42 @@ namespace mico {
     }
 
 
+    /**
+     * 64bit FNV-1a over the mapping from URIs to vertice ids, the edges (as 64bit words) and the
+     * data added by subclasses, finished with the MurmurHash3 finalizer. The URI mapping is
+     * combined independently of its order in the hash table, which differs after restoring a dump.
+     */
+    uint64_t rgraph::fingerprint() const {
+      uint64_t h = 0xcbf29ce484222325ULL;
+      uint64_t u = 0;
+      int e, ecount = igraph_ecount(graph);
+      const char* key;
+      int id;
+
+      kh_foreach(uris, key, id, 
+		 uint64_t k = 0xcbf29ce484222325ULL;
+		 for(const char* c = key; *c; c++) {
+		   k = (k ^ (unsigned char)*c) * 0x100000001b3ULL;
+		 }
+		 u += mix64(k ^ (uint64_t)id);
+		 );
+
+      h = (h ^ (uint64_t)num_vertices) * 0x100000001b3ULL;
+      h = (h ^ (uint64_t)ecount) * 0x100000001b3ULL;
+      h = (h ^ u) * 0x100000001b3ULL;
+
+      for(e=0; e<ecount; e++) {
+	uint64_t from = (uint64_t)VECTOR(graph->from)[e];
+	uint64_t to   = (uint64_t)VECTOR(graph->to)[e];
+	h = (h ^ ((from << 32) | to)) * 0x100000001b3ULL;
+      }
+
+      h = fingerprint_hook(h);
+
+      return mix64(h);
+    }
+
+
     /**
      * Destroy all resources claimed by a relatedness graph
      */
@@ -77,6 +122,10 @@ namespace mico {
 
       kh_destroy(uris, uris);
 
+      delete adj;
+      delete sketch;
+      delete embedding;
+
       pthread_rwlock_destroy(&mutex_v);
       pthread_mutex_destroy(&mutex_g);
 
@@ -98,6 +147,57 @@ namespace mico {
 
 
 
+    /**
+     * lookup the vertice ids of the n given uris at once. Works in batches of RESOLVE_BATCH uris:
+     * first compute all hashes and prefetch the hash buckets, then prefetch the key strings found
+     * in the buckets, and finally probe the hash table as kh_get does.
+     */
+    void rgraph::get_vertice_ids(const char* const* names, int n, int* ids) const {
+      khint_t hashes[RESOLVE_BATCH];
+      khint_t i, b, m, k, last, mask, step;
+
+      if(uris->n_buckets == 0) {
+	for(b=0; b<(khint_t)n; b++) {
+	  ids[b] = -1;
+	}
+	return;
+      }
+      mask = uris->n_buckets - 1;
+
+      for(b=0; b<(khint_t)n; b+=RESOLVE_BATCH) {
+	m = (khint_t)n - b < RESOLVE_BATCH ? (khint_t)n - b : RESOLVE_BATCH;
+
+	for(i=0; i<m; i++) {
+	  hashes[i] = kh_str_hash_func(names[b+i]);
+	  k = hashes[i] & mask;
+	  __builtin_prefetch(&uris->flags[k>>4]);
+	  __builtin_prefetch(&uris->keys[k]);
+	  __builtin_prefetch(&uris->vals[k]);
+	}
+
+	for(i=0; i<m; i++) {
+	  k = hashes[i] & mask;
+	  if(!__ac_iseither(uris->flags, k)) {
+	    __builtin_prefetch(uris->keys[k]);
+	  }
+	}
+
+	for(i=0; i<m; i++) {
+	  k = last = hashes[i] & mask;
+	  step = 0;
+	  while (!__ac_isempty(uris->flags, k) && (__ac_isdel(uris->flags, k) || !kh_str_hash_equal(uris->keys[k], names[b+i]))) {
+	    k = (k + (++step)) & mask;
+	    if (k == last) {
+	      k = uris->n_buckets;
+	      break;
+	    }
+	  }
+	  ids[b+i] = k == uris->n_buckets || __ac_iseither(uris->flags, k) ? -1 : kh_val(uris, k);
+	}
+      }
+    }
+
+
     void rgraph::set_vertice_id(const char* uri, int vid) {
       int err;
       khiter_t k = kh_put(uris, uris, uri, &err);
@@ -105,6 +205,17 @@ namespace mico {
     } 
 
 
+    const adjacency* rgraph::get_adjacency() {
+      lock_graph();
+      if(adj == NULL) {
+	adj = new adjacency(*this);
+      }
+      unlock_graph();
+
+      return adj;
+    }
+
+
 
 
 
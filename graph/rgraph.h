@@ -5,6 +5,7 @@
 #include <iostream>
 #include <vector>
 #include <pthread.h>
+#include <stdint.h>
 #include <string.h>
 #include <igraph/igraph.h>
 #include "khash.h"
@@ -34,6 +35,9 @@ namespace mico {
       class parser;
     }
 
+    class adjacency;
+    class sketches;
+    class embeddings;
 
 
     class rgraph {
@@ -46,6 +50,9 @@ namespace mico {
 
       kh_uris_t       *uris;        /* map from URIs to vertice IDs */
 
+      sketches        *sketch;      /* neighborhood sketches of all vertices (optional) */
+      embeddings      *embedding;   /* embedding vectors of all vertices (optional) */
+
     protected:
       friend class mico::graph::rdf::parser;
       friend class mico::relatedness::shortest_path;
@@ -53,6 +60,8 @@ namespace mico {
       pthread_rwlock_t mutex_v;      /* vertice mutex */
       pthread_mutex_t  mutex_g;      /* graph mutex  */
 
+      adjacency*       adj;          /* compact neighborhood representation, built on demand */
+
       // override in subclasses in case more data needs to be written to the stream after the
       // initial data has been written
       virtual void dump_stream_hook(std::ostream& os) const {};
@@ -61,6 +70,10 @@ namespace mico {
       // initial data has been read
       virtual void restore_stream_hook(std::istream& is) {};
 
+      // override in subclasses in case more data determines the identity of the graph; returns
+      // the given hash value updated with the additional data
+      virtual uint64_t fingerprint_hook(uint64_t h) const { return h; };
+
     public:
 
       /**
@@ -92,6 +105,13 @@ namespace mico {
 
       inline int edge_count() const { return igraph_ecount(graph); };
 
+      /**
+       * Compute a 64bit hash of the vertice URIs, edges and (in subclasses) edge weights of the
+       * graph. Files derived from a graph (e.g. precomputed relatedness values) store the
+       * fingerprint so that they are not used with a different graph.
+       */
+      uint64_t fingerprint() const;
+
       /**
        * lookup the vertice URI of the vertice with the given ID. NUL in case the ID is smaller 0 or
        * larger than num_vertices
@@ -106,6 +126,13 @@ namespace mico {
        */
       int get_vertice_id(const char* uri) const;
 
+      /**
+       * lookup the vertice ids of the n given uris at once and store them in ids (-1 for uris not
+       * contained in the graph). Faster than individual lookups for many uris, because the hash
+       * table accesses of several uris are overlapped using memory prefetching.
+       */
+      void get_vertice_ids(const char* const* uris, int n, int* ids) const;
+
 
       /**
        * set the vertice id of the vertice representing the given uri. Overrides any previously existing
@@ -113,6 +140,14 @@ namespace mico {
        */
       void set_vertice_id(const char* uri, int vid); 
 
+
+      /**
+       * Return the compact undirected adjacency of the graph (sorted neighbor lists), building it
+       * on first access. Safe to call from multiple threads. The graph must not be modified
+       * afterwards.
+       */
+      const adjacency* get_adjacency();
+
       
       /**
        * Dump the complete graph data structure to a output stream. Uses rgraph's internal binary
@@ -122,7 +157,8 @@ namespace mico {
 
       /**
        * Dump the complete graph data structure to a binary file. Uses rgraph's internal binary
-       * format for graph representation.
+       * format for graph representation. Neighborhood sketches and embeddings, if present, are
+       * written to separate files with the suffixes SKETCH_SUFFIX and EMBEDDING_SUFFIX.
        */
       void dump_file(const char* filename) const;
 
@@ -136,7 +172,8 @@ namespace mico {
 
       /**
        * Restore the complete graph data structure from a binary file. Uses rgraph's internal
-       * binary format for graph representation.
+       * binary format for graph representation. In case sketch or embedding files with the
+       * suffixes SKETCH_SUFFIX and EMBEDDING_SUFFIX exist, they are mapped into memory.
        */
       void restore_file(const char* filename);
 
@@ -203,6 +240,9 @@ namespace mico {
       // read weights from stream
       virtual void restore_stream_hook(std::istream& is);
 
+      // add weights to the fingerprint
+      virtual uint64_t fingerprint_hook(uint64_t h) const;
+
 
     public:
       std::vector<double> weights;     /* vector containing edge weights */
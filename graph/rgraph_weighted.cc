@@ -1,4 +1,5 @@
 #include <iostream>
+#include <string.h>
 #include "rgraph.h"
 
 
@@ -33,5 +34,15 @@ namespace mico {
       }
       std::cout << weights.size() << " weights!\n";
     }
+
+
+    uint64_t rgraph_weighted::fingerprint_hook(uint64_t h) const {
+      for(size_t i=0; i<weights.size(); i++) {
+	uint64_t w;
+	memcpy(&w, &weights[i], sizeof(uint64_t));
+	h = (h ^ w) * 0x100000001b3ULL;
+      }
+      return h;
+    }
   }
 }
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <fstream>
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include "sketches.h"
+#include "../config.h"
+
+#define SKETCH_MAGIC   "WSDSKTCH"
+#define SKETCH_VERSION 2
+
+namespace mico {
+  namespace graph {
+
+    // binary file header, padded to 32 bytes so the sketch array stays aligned
+    struct sketch_header {
+      char     magic[8];
+      int32_t  version;
+      int32_t  size;
+      int32_t  hops;
+      int32_t  num_vertices;
+      uint64_t fingerprint;
+    };
+
+
+    sketches::sketches(int num_vertices, int size, int hops)
+      : mapped(false), map_length(0), map_base(NULL), hops(hops), num_vertices(num_vertices) {
+      this->size = (size + SKETCH_ALIGN - 1) / SKETCH_ALIGN * SKETCH_ALIGN;
+
+      data = new uint32_t[(long int)num_vertices * this->size];
+      for(long int i=0; i<(long int)num_vertices * this->size; i++) {
+	data[i] = SKETCH_EMPTY;
+      }
+    }
+
+
+    sketches::~sketches() {
+      if(mapped) {
+	munmap(map_base, map_length);
+      } else {
+	delete[] data;
+      }
+    }
+
+
+    void sketches::dump_file(const char* filename, uint64_t fingerprint) const {
+      std::cout << "- dumping sketch data ...\n";
+
+      sketch_header h;
+      memset(&h, 0, sizeof(h));
+      memcpy(h.magic, SKETCH_MAGIC, 8);
+      h.version      = SKETCH_VERSION;
+      h.size         = size;
+      h.hops         = hops;
+      h.num_vertices = num_vertices;
+      h.fingerprint  = fingerprint;
+
+      std::ofstream os(filename);
+      os.write((char*)&h, sizeof(h));
+      os.write((char*)data, (long int)num_vertices * size * sizeof(uint32_t));
+    }
+
+
+    sketches* sketches::map_file(const char* filename, uint64_t fingerprint, int num_vertices) {
+      struct stat buf;
+      sketch_header* h;
+
+      int fd = open(filename, O_RDONLY);
+      if(fd < 0) {
+	return NULL;
+      }
+      if(fstat(fd, &buf) < 0 || (size_t)buf.st_size < sizeof(sketch_header)) {
+	close(fd);
+	return NULL;
+      }
+
+      void* base = mmap(0, buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      close(fd);
+      if(base == MAP_FAILED) {
+	return NULL;
+      }
+
+      h = (sketch_header*)base;
+      if(memcmp(h->magic, SKETCH_MAGIC, 8) != 0 || h->version != SKETCH_VERSION
+	 || (size_t)buf.st_size < sizeof(sketch_header) + (size_t)h->num_vertices * h->size * sizeof(uint32_t)) {
+	std::cerr << "invalid sketch file " << filename << ", ignoring\n";
+	munmap(base, buf.st_size);
+	return NULL;
+      }
+      if(h->fingerprint != fingerprint || h->num_vertices != num_vertices) {
+	std::cerr << "sketch file " << filename << " was computed for a different graph, ignoring\n";
+	munmap(base, buf.st_size);
+	return NULL;
+      }
+
+      sketches* s = new sketches();
+      s->mapped       = true;
+      s->map_base     = base;
+      s->map_length   = buf.st_size;
+      s->size         = h->size;
+      s->hops         = h->hops;
+      s->num_vertices = h->num_vertices;
+      s->data         = (uint32_t*)((char*)base + sizeof(sketch_header));
+
+      std::cout << "- mapped " << s->num_vertices << " neighborhood sketches (" << s->hops << " hops) from " << filename << "\n";
+
+      return s;
+    }
+
+  }
+}
@@ -0,0 +1,72 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_SKETCHES_H
+#define HAVE_SKETCHES_H 1
+
+#include <stdint.h>
+
+namespace mico {
+  namespace graph {
+
+    /**
+     * Per-vertice MinHash sketches of the k-hop neighborhood of each vertice in the knowledge
+     * graph. Sketches use one-permutation hashing: each neighbor is hashed once into one of
+     * `size` bins, and each bin keeps the minimum hash value seen (SKETCH_EMPTY for empty bins).
+     * The fraction of non-empty bins two sketches agree on estimates the Jaccard coefficient of the
+     * two neighborhoods.
+     *
+     * Sketches are stored as a fixed-width array (size 32bit values per vertice) in a separate
+     * file next to the graph dump (<prefix>.sketches) so that they can be mapped into memory
+     * directly. File format: 32 bytes header (8 bytes magic "WSDSKTCH", 4 bytes version, 4 bytes
+     * sketch size, 4 bytes number of hops, 4 bytes number of vertices, 8 bytes graph fingerprint),
+     * followed by the sketch array in host byte order. Sketches are only valid for the graph they
+     * were computed on (vertice ids change when the graph is rebuilt), so the file is ignored if
+     * its fingerprint (rgraph::fingerprint) or number of vertices does not match the graph.
+     */
+    class sketches {
+
+      bool      mapped;      /* true in case data points into a mapped file */
+      size_t    map_length;  /* length of the mapping (if mapped) */
+      void*     map_base;    /* start of the mapping (if mapped) */
+
+      sketches() {};
+
+    public:
+      int       size;         /* number of bins per sketch, always a multiple of SKETCH_ALIGN */
+      int       hops;         /* size of the neighborhoods represented by the sketches */
+      int       num_vertices; /* number of sketches */
+      uint32_t* data;         /* num_vertices * size bin values */
+
+      /**
+       * Allocate empty sketches of the given size (rounded up to a multiple of SKETCH_ALIGN)
+       * for the given number of vertices.
+       */
+      sketches(int num_vertices, int size, int hops);
+
+      /**
+       * Free or unmap the sketch data.
+       */
+      ~sketches();
+
+      /**
+       * The sketch of the vertice with the given id.
+       */
+      inline uint32_t* get(int v) const { return data + (long int)v * size; };
+
+      /**
+       * Write the sketches of the graph with the given fingerprint to a binary file in the format
+       * described above.
+       */
+      void dump_file(const char* filename, uint64_t fingerprint) const;
+
+      /**
+       * Map the sketches stored in the given binary file into memory (read only). Returns NULL in
+       * case the file does not exist, is not a valid sketch file or was computed for a graph with
+       * a different fingerprint or number of vertices.
+       */
+      static sketches* map_file(const char* filename, uint64_t fingerprint, int num_vertices);
+    };
+
+  }
+}
+
+#endif
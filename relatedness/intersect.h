@@ -0,0 +1,135 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_INTERSECT_H
+#define HAVE_INTERSECT_H 1
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Intersection kernels for sorted lists of 32bit vertice ids (as found in the compact adjacency of
+ * an rgraph). All functions call a functor f(v) for each element v contained in both lists, in
+ * ascending order.
+ *
+ * For lists of similar size, a merge is used that compares blocks of 4x4 elements with SSE2
+ * instructions where available. For very skewed sizes (the larger list at least
+ * INTERSECT_GALLOP_RATIO times longer), each element of the smaller list is instead searched in
+ * the larger one with galloping (exponential) search.
+ */
+
+#define INTERSECT_GALLOP_RATIO 32
+
+namespace mico {
+  namespace relatedness {
+
+    /**
+     * Scalar merge intersection of a[i..na) and b[j..nb).
+     */
+    template<class F> inline void intersect_scalar(const uint32_t* a, size_t i, size_t na, const uint32_t* b, size_t j, size_t nb, F& f) {
+      while(i < na && j < nb) {
+	if(a[i] < b[j]) {
+	  i++;
+	} else if(a[i] > b[j]) {
+	  j++;
+	} else {
+	  f(a[i]);
+	  i++; j++;
+	}
+      }
+    }
+
+
+    /**
+     * Galloping intersection; small is searched element by element in large.
+     */
+    template<class F> inline void intersect_gallop(const uint32_t* small, size_t ns, const uint32_t* large, size_t nl, F& f) {
+      size_t lo = 0, hi, step, mid;
+
+      for(size_t i=0; i<ns && lo < nl; i++) {
+	uint32_t v = small[i];
+
+	// exponential search for an upper bound
+	step = 1;
+	hi   = lo;
+	while(hi < nl && large[hi] < v) {
+	  lo   = hi + 1;
+	  hi  += step;
+	  step <<= 1;
+	}
+	if(hi > nl) {
+	  hi = nl;
+	}
+
+	// binary search in [lo,hi)
+	while(lo < hi) {
+	  mid = (lo + hi) >> 1;
+	  if(large[mid] < v) {
+	    lo = mid + 1;
+	  } else {
+	    hi = mid;
+	  }
+	}
+
+	if(lo < nl && large[lo] == v) {
+	  f(v);
+	  lo++;
+	}
+      }
+    }
+
+
+    /**
+     * Intersect two sorted lists without duplicates, choosing the best kernel for their sizes.
+     */
+    template<class F> inline void intersect(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, F& f) {
+      if(na * INTERSECT_GALLOP_RATIO < nb) {
+	intersect_gallop(a, na, b, nb, f);
+	return;
+      }
+      if(nb * INTERSECT_GALLOP_RATIO < na) {
+	intersect_gallop(b, nb, a, na, f);
+	return;
+      }
+
+      size_t i = 0, j = 0;
+
+#ifdef __SSE2__
+      // compare blocks of four elements of a with all rotations of four elements of b; the
+      // resulting mask tells which elements of the a block are contained in the b block
+      while(i + 4 <= na && j + 4 <= nb) {
+	__m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+	__m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+
+	__m128i m = _mm_or_si128(
+	  _mm_or_si128(_mm_cmpeq_epi32(va, vb),
+		       _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0,3,2,1)))),
+	  _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1,0,3,2))),
+		       _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2,1,0,3)))));
+
+	int mask = _mm_movemask_ps(_mm_castsi128_ps(m));
+	while(mask) {
+	  int k = __builtin_ctz(mask);
+	  f(a[i+k]);
+	  mask &= mask - 1;
+	}
+
+	uint32_t amax = a[i+3], bmax = b[j+3];
+	if(amax <= bmax) {
+	  i += 4;
+	}
+	if(bmax <= amax) {
+	  j += 4;
+	}
+      }
+#endif
+
+      intersect_scalar(a, i, na, b, j, nb, f);
+    }
+
+  }
+}
+
+#endif
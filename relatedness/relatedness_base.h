@@ -2,6 +2,8 @@
 #ifndef HAVE_RELATEDNESS_BASE_H
 #define HAVE_RELATEDNESS_BASE_H 1
 
+#include <float.h>
+
 #include "../graph/rgraph.h"
 
 
@@ -12,17 +14,72 @@ namespace mico {
      * Base class for different implementations of relatedness. Subclasses can hold their own thread
      * state for computing relatedness to improve performance for sequential calls; instances are never
      * shared between threads. 
+     *
+     * Implementations work on vertice ids of the knowledge graph; callers computing many relatedness
+     * values for the same resources should resolve the URIs only once (e.g. using
+     * rgraph::get_vertice_ids) and use the id-based method.
      */
     class base {
 
+    protected:
+
+      // graph used for resolving URIs to vertice ids
+      const mico::graph::rgraph* index;
+
+      // maximum number of edges to take into account in the knowledge graph
+      int max_dist;
+
+      // relatedness values above the cutoff are reported as unrelated (DBL_MAX)
+      double cutoff;
+
     public:
 
+      base(const mico::graph::rgraph* index, int max_dist = 0) : index(index), max_dist(max_dist), cutoff(DBL_MAX) {};
+
+      virtual ~base() {};
+
+      /**
+       * Set the maximum relatedness value of interest. Values above the cutoff are reported as
+       * DBL_MAX (unrelated), and search-based implementations use it to stop exploring the graph
+       * early.
+       */
+      inline void set_cutoff(double cutoff) { this->cutoff = cutoff; };
+
       /**
-       * Compute the relatedness between the two URIs given as argument. The max_dist parameter is used
-       * by some implementations to limit the maximum number of edges to take into account in the
+       * Change the maximum distance used for following computations. Allows reusing an instance
+       * (and its helper structures) for requests with different maximum distances.
+       */
+      inline void set_max_dist(int max_dist) { this->max_dist = max_dist; };
+
+      /**
+       * Compute the relatedness between the two vertices given as argument. The max_dist parameter is
+       * used by some implementations to limit the maximum number of edges to take into account in the
        * knowledge graph.
        */
-      virtual double relatedness(const char* from, const char* to) = 0;
+      virtual double relatedness(int from, int to) = 0;
+
+      /**
+       * Compute the relatedness between the vertice from and each of the n vertices in to, storing
+       * the results in result. Implementations searching the graph from the source (shortest path)
+       * answer all targets with one search; the default computes them one by one. The results are
+       * the same as those of the single-target method.
+       */
+      virtual void relatedness(int from, const int* to, int n, double* result) {
+	for(int i=0; i<n; i++) {
+	  result[i] = relatedness(from, to[i]);
+	}
+      };
+
+      /**
+       * Compute the relatedness between the two URIs given as argument. Returns DBL_MAX (unrelated) in
+       * case one of the URIs is not contained in the knowledge graph.
+       */
+      inline double relatedness(const char* from, const char* to) {
+	int f = index->get_vertice_id(from);
+	int t = index->get_vertice_id(to);
+
+	return f == -1 || t == -1 ? DBL_MAX : relatedness(f, t);
+      };
 
 
     };
@@ -3,12 +3,9 @@
 namespace mico {
   namespace relatedness {
 
-    double cluster::relatedness(const char* sfrom, const char* sto) {
+    double cluster::relatedness(int from, int to) {
 
-      int from = graph->get_vertice_id(sfrom);
-      int to   = graph->get_vertice_id(sto);
-
-      if(from == -1 || to == -1 || from >= graph->num_vertices || to >= graph->num_vertices) {
+      if(from < 0 || to < 0 || from >= graph->num_vertices || to >= graph->num_vertices) {
 	return 1.0; // not related
       }
 
@@ -24,13 +24,15 @@ namespace mico {
       /**
        * Initialise a shortest path computation over the given graph up to the given maximum distance.
        */
-      cluster(rgraph_clustered* graph, int max_dist) : graph(graph) {};
+      cluster(rgraph_clustered* graph, int max_dist) : base(graph, max_dist), graph(graph) {};
 
 
       /**
        * Relatedness computation via cluster comparison of the two nodes. 
        */
-      double relatedness(const char* from, const char* to);
+      double relatedness(int from, int to);
+
+      using base::relatedness;
 
 
     };
@@ -0,0 +1,269 @@
+#include <float.h>
+#include <string.h>
+#include <sched.h>
+
+#include "relatedness_delta_stepping.h"
+#include "../config.h"
+
+using namespace mico::graph;
+
+namespace mico {
+  namespace relatedness {
+
+    static inline uint64_t to_bits(double d) {
+      uint64_t bits;
+      memcpy(&bits, &d, sizeof(bits));
+      return bits;
+    }
+
+    static inline double from_bits(uint64_t bits) {
+      double d;
+      memcpy(&d, &bits, sizeof(d));
+      return d;
+    }
+
+
+    // constructor: initialise helper structures
+    delta_stepping::delta_stepping(rgraph_weighted* graph, int max_dist)
+      : base(graph, max_dist), graph(graph), delta(1.0), done(0), limit(0), cursor(0), phase(0), started(0), running(false) {
+      dist  = new std::atomic<uint64_t>[graph->num_vertices];
+      level = new std::atomic<int>[graph->num_vertices];
+
+      pthread_mutex_init(&merge_mutex,NULL);
+    }
+
+    // destructor: free helper structures
+    delta_stepping::~delta_stepping() {
+      pthread_mutex_destroy(&merge_mutex);
+
+      delete[] dist;
+      delete[] level;
+    }
+
+
+    double delta_stepping::distance(int v) const {
+      return from_bits(dist[v].load(std::memory_order_relaxed));
+    }
+
+
+    bool delta_stepping::relax(int v, double d) {
+      uint64_t bits = to_bits(d);
+      uint64_t old  = dist[v].load(std::memory_order_relaxed);
+
+      while(bits < old) {
+	if(dist[v].compare_exchange_weak(old, bits, std::memory_order_relaxed)) {
+	  return true;
+	}
+      }
+      return false;
+    }
+
+
+    void delta_stepping::process(phase_type type, const int* items, long first, long last) {
+      long i, j, k, e, eid;
+      int  u, v, d;
+      double du, w;
+
+      igraph_t* g = graph->graph;
+
+      std::vector<int>                     next;
+      std::vector<std::pair<long, int> >   inserted;
+      double                               sum = 0.0;
+      long                                 seen = 0;
+
+      for(k=first; k<last; k++) {
+
+	if(type == RESET) {
+	  dist[k].store(to_bits(DBL_MAX), std::memory_order_relaxed);
+	  level[k].store(-1, std::memory_order_relaxed);
+	  continue;
+	}
+
+	u  = items[k];
+	du = distance(u);
+
+	if(type == LIGHT) {
+	  if((long)(du / delta) != bucket) {
+	    continue; // stale entry, vertice has moved to a lower bucket in the meantime
+	  }
+	  next.push_back(u);
+	}
+
+	// process outgoing (d=0) and incoming (d=1) edges and vertices
+	for(d=0; d<2; d++) {
+	  igraph_vector_t& index = d == 0 ? g->os : g->is;
+	  igraph_vector_t& edges = d == 0 ? g->oi : g->ii;
+	  igraph_vector_t& other = d == 0 ? g->to : g->from;
+
+	  j=(long int) VECTOR(index)[u+1];
+	  for (i=(long int) VECTOR(index)[u]; i<j; i++) {
+	    eid = (long int)VECTOR(edges)[i];
+	    v   = (int)VECTOR(other)[eid];
+	    w   = graph->weights[eid];
+
+	    switch(type) {
+	    case COLLECT:
+	      sum += w;
+	      seen++;
+	      e = level[u].load(std::memory_order_relaxed) + 1;
+	      {
+		int unvisited = -1;
+		if(level[v].compare_exchange_strong(unvisited, (int)e, std::memory_order_relaxed) && e < max_dist) {
+		  next.push_back(v);
+		}
+	      }
+	      break;
+	    case LIGHT:
+	    case HEAVY:
+	      if((type == LIGHT) == (w <= delta) && du + w <= cutoff && relax(v, du + w) && level[v].load(std::memory_order_relaxed) >= 0) {
+		inserted.push_back(std::make_pair((long)((du + w) / delta), v));
+	      }
+	      break;
+	    default:
+	      break;
+	    }
+	  }
+	}
+      }
+
+      if(type == RESET) {
+	return;
+      }
+
+      // merge results of this chunk into the shared structures
+      pthread_mutex_lock(&merge_mutex);
+      if(type == COLLECT) {
+	frontier.insert(frontier.end(), next.begin(), next.end());
+	weight_sum   += sum;
+	weight_count += seen;
+      } else {
+	settled.insert(settled.end(), next.begin(), next.end());
+	for(std::vector<std::pair<long, int> >::iterator it = inserted.begin(); it != inserted.end(); ++it) {
+	  buckets[it->first].push_back(it->second);
+	}
+      }
+      pthread_mutex_unlock(&merge_mutex);
+    }
+
+
+    bool delta_stepping::work() {
+      bool worked = false;
+
+      while(1) {
+	uint64_t c   = cursor.load(std::memory_order_acquire);
+	uint64_t l   = limit.load(std::memory_order_acquire);
+	long     pos = (long)(c & 0xFFFFFFFFu);
+	long     n   = (long)(l & 0xFFFFFFFFu);
+
+	// nothing left, or a new phase is just being published
+	if((c >> 32) != (l >> 32) || pos >= n) {
+	  return worked;
+	}
+
+	// claim the next chunk; fails if another thread was faster or the phase has changed
+	if(!cursor.compare_exchange_weak(c, c + DELTA_STEPPING_CHUNK, std::memory_order_acq_rel)) {
+	  continue;
+	}
+
+	// the phase cannot end before this chunk is done, so the phase fields are stable now
+	long last = pos + DELTA_STEPPING_CHUNK < n ? pos + DELTA_STEPPING_CHUNK : n;
+
+	process(type, items, pos, last);
+	done.fetch_add(last - pos, std::memory_order_acq_rel);
+	worked = true;
+      }
+    }
+
+
+    void delta_stepping::run_phase(phase_type type, const int* items, long count) {
+      this->type  = type;
+      this->items = items;
+      this->done.store(0, std::memory_order_relaxed);
+
+      phase++;
+      limit.store(((uint64_t)phase << 32) | (uint64_t)count, std::memory_order_release);
+      cursor.store((uint64_t)phase << 32, std::memory_order_release);
+
+      work();
+      while(done.load(std::memory_order_acquire) < count) {
+	sched_yield();
+      }
+    }
+
+
+    void delta_stepping::help(unsigned search) {
+      while(started.load(std::memory_order_acquire) < search) {
+	sched_yield();
+      }
+
+      while(running.load(std::memory_order_acquire) && started.load(std::memory_order_acquire) == search) {
+	if(!work()) {
+	  sched_yield();
+	}
+      }
+    }
+
+
+    double delta_stepping::relatedness(int from, int to) {
+      int k;
+
+      if(from < 0 || to < 0 || from >= graph->num_vertices || to >= graph->num_vertices) {
+	started.fetch_add(1, std::memory_order_acq_rel);
+	return DBL_MAX;
+      }
+
+      running.store(true, std::memory_order_release);
+      started.fetch_add(1, std::memory_order_acq_rel);
+
+      // reset distances and levels of all vertices
+      run_phase(RESET, NULL, graph->num_vertices);
+
+      // collect the search space: all vertices up to max_dist edges away from the start vertice
+      // (breadth-first, one phase per level); as a side effect, compute the mean edge weight of
+      // the search space which is used as bucket width
+      weight_sum   = 0.0;
+      weight_count = 0;
+      level[from].store(0, std::memory_order_relaxed);
+      current.assign(1, from);
+      for(k=0; k<max_dist && !current.empty(); k++) {
+	frontier.clear();
+	run_phase(COLLECT, &current[0], current.size());
+	current.swap(frontier);
+      }
+      delta = weight_count > 0 && weight_sum > 0.0 ? weight_sum / weight_count : 1.0;
+
+      // delta-stepping over the search space
+      buckets.clear();
+      dist[from].store(to_bits(0.0), std::memory_order_relaxed);
+      buckets[0].push_back(from);
+
+      while(!buckets.empty()) {
+	bucket = buckets.begin()->first;
+
+	// all vertices closer than the current bucket have their final distance; stop if this
+	// includes the target vertice or the remaining vertices are beyond the cutoff
+	if(distance(to) < bucket * delta || bucket * delta > cutoff) {
+	  break;
+	}
+
+	// relax light edges until the bucket stays empty, remembering the removed vertices
+	settled.clear();
+	while(!buckets.empty() && buckets.begin()->first == bucket) {
+	  current.swap(buckets.begin()->second);
+	  buckets.erase(buckets.begin());
+
+	  run_phase(LIGHT, &current[0], current.size());
+	}
+
+	// relax heavy edges of all removed vertices once
+	current.swap(settled);
+	run_phase(HEAVY, current.empty() ? NULL : &current[0], current.size());
+      }
+
+      running.store(false, std::memory_order_release);
+
+      return distance(to) <= cutoff ? distance(to) : DBL_MAX;
+    }
+
+  }
+}
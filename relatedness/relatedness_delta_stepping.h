@@ -0,0 +1,131 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_RELATEDNESS_DELTA_STEPPING
+#define HAVE_RELATEDNESS_DELTA_STEPPING 1
+
+#include <map>
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "relatedness_base.h"
+
+namespace mico {
+
+  namespace relatedness {
+
+    /**
+     * A parallel implementation of shortest path relatedness using delta-stepping (Meyer and
+     * Sanders). Vertices are kept in buckets of width delta according to their tentative
+     * distance; all vertices in the current bucket are relaxed in parallel, first along their light
+     * edges (weight <= delta) until the bucket stays empty, then once along their heavy edges. Like
+     * shortest_path, only vertices up to max_dist edges away from the start vertice are expanded,
+     * and the search stops as soon as the distance of the target vertice is final or all remaining
+     * vertices are further away than the cutoff.
+     *
+     * The computation does not own any threads. The thread calling relatedness() drives the
+     * search through a sequence of phases (reset, breadth-first collection of the search space,
+     * light and heavy relaxation); any number of other threads may call help() concurrently to
+     * work on the current phase. The work of each phase is handed out in chunks of
+     * DELTA_STEPPING_CHUNK items using an atomic cursor. Without helpers, the search simply runs
+     * in the calling thread.
+     *
+     * Only one search may run at a time, i.e. relatedness() must not be called concurrently on the
+     * same instance.
+     */
+    class delta_stepping : public virtual base {
+
+      // phases of a search
+      enum phase_type { RESET, COLLECT, LIGHT, HEAVY };
+
+      mico::graph::rgraph_weighted* graph;
+
+      // tentative distances (as bit patterns; non-negative doubles have the same order as their
+      // bit patterns, so they can be updated with an integer compare-and-swap)
+      std::atomic<uint64_t>* dist;
+
+      // number of edges from the start vertice, -1 for vertices outside the search space
+      std::atomic<int>*      level;
+
+      double                 delta;
+
+      // buckets of vertices to be processed, indexed by tentative distance / delta
+      std::map<long, std::vector<int> > buckets;
+
+      std::vector<int>       current;   // vertices of the current phase
+      std::vector<int>       settled;   // vertices removed from the current bucket
+      std::vector<int>       frontier;  // next breadth-first level
+      double                 weight_sum;
+      long                   weight_count;
+      pthread_mutex_t        merge_mutex;
+
+      // current phase, shared with helper threads; limit and cursor hold the phase number in the
+      // upper and the number of items / the next item in the lower 32 bits
+      phase_type             type;
+      const int*             items;
+      long                   bucket;
+      std::atomic<long>      done;
+      std::atomic<uint64_t>  limit;
+      std::atomic<uint64_t>  cursor;
+      uint32_t               phase;
+
+      // number of searches started so far and state of the current one
+      std::atomic<unsigned>  started;
+      std::atomic<bool>      running;
+
+
+      // distance of a vertice
+      double distance(int v) const;
+
+      // lower the distance of v to d if it is smaller, returns true in that case
+      bool relax(int v, double d);
+
+      // publish a new phase and work on it until all items are processed
+      void run_phase(phase_type type, const int* items, long count);
+
+      // process chunks of the current phase until there are none left; returns false if there was
+      // nothing to do
+      bool work();
+
+      // process the given items of the current phase
+      void process(phase_type type, const int* items, long first, long last);
+
+
+    public:
+
+      /**
+       * Initialise a parallel shortest path computation over the given graph up to the given
+       * maximum distance.
+       */
+      delta_stepping(mico::graph::rgraph_weighted* graph, int max_dist);
+
+      /**
+       * Cleanup helper structures
+       */
+      ~delta_stepping();
+
+      /**
+       * Relatedness computation via shortest path computation in the underlying graph up to a
+       * maximum distance, using the threads calling help() in parallel.
+       */
+      double relatedness(int from, int to);
+
+      using base::relatedness;
+
+      /**
+       * Number of searches started by relatedness() so far (including searches that ended
+       * immediately because a vertice was unknown).
+       */
+      inline unsigned searches() const { return started.load(std::memory_order_acquire); };
+
+      /**
+       * Work on the given search (as counted by searches()) in the calling thread. Waits until the
+       * search has been started and returns when it has finished.
+       */
+      void help(unsigned search);
+
+    };
+  }
+}
+
+#endif
@@ -11,7 +11,7 @@ using namespace mico::graph;
 using namespace mico::relatedness;
 
 // constructor: initialise helper structures
-mico::relatedness::dfs::dfs(rgraph_weighted* graph, int max_dist) : graph(graph), max_dist(max_dist) {
+mico::relatedness::dfs::dfs(rgraph_weighted* graph, int max_dist) : base(graph, max_dist), graph(graph) {
   dist = new double[graph->num_vertices];
 }
 
@@ -20,20 +20,24 @@ mico::relatedness::dfs::~dfs() {
   delete[] dist;
 }
 
-// DFS to compute distances for all vertices up to a certain depth
+// DFS to compute distances for all vertices up to a certain depth; paths that are already longer
+// than the best known path to the target or the cutoff cannot lead to a better result (weights are
+// non-negative) and are pruned
 inline void mico::relatedness::dfs::collect(int node, double pweight, int depth) {
   long int i, j, eid;
-  igraph_integer_t v, w;
+  igraph_integer_t v;
+  double alt;
 
   j=(long int) VECTOR(graph->graph->os)[node+1];
   for (i=(long int) VECTOR(graph->graph->os)[node]; i<j; i++) {
     eid = (long int)VECTOR(graph->graph->oi)[i];
     v   = VECTOR(graph->graph->to)[eid];
 
-    if(dist[v] > pweight + graph->weights[eid]) {
-      dist[v] = pweight + graph->weights[eid];
-      if(depth > 1) {
-	collect(v, dist[v], depth-1);
+    alt = pweight + graph->weights[eid];
+    if(alt < dist[v] && alt < dist[target] && alt <= cutoff) {
+      dist[v] = alt;
+      if(depth > 1 && v != target) {
+	collect(v, alt, depth-1);
       }
     }
   }
@@ -43,25 +47,21 @@ inline void mico::relatedness::dfs::collect(int node, double pweight, int depth)
     eid = (long int)VECTOR(graph->graph->ii)[i];
     v   = VECTOR(graph->graph->from)[eid];
     
-    if(dist[v] > pweight + graph->weights[eid]) {
-      dist[v] = pweight + graph->weights[eid];
-      if(depth > 1) {
-	collect(v, dist[v], depth-1);
+    alt = pweight + graph->weights[eid];
+    if(alt < dist[v] && alt < dist[target] && alt <= cutoff) {
+      dist[v] = alt;
+      if(depth > 1 && v != target) {
+	collect(v, alt, depth-1);
       }
     }
   }
 
 }
 
-double mico::relatedness::dfs::relatedness(const char* sfrom, const char* sto) {
-  long int i, j, u, v, eid;
-
-  double alt;
-
-  int from = graph->get_vertice_id(sfrom);
-  int to   = graph->get_vertice_id(sto);
+double mico::relatedness::dfs::relatedness(int from, int to) {
+  long int i;
 
-  if(from == -1 || to == -1 || from >= graph->num_vertices || to >= graph->num_vertices) {
+  if(from < 0 || to < 0 || from >= graph->num_vertices || to >= graph->num_vertices) {
     return DBL_MAX;
   }
 
@@ -70,10 +70,11 @@ double mico::relatedness::dfs::relatedness(const char* sfrom, const char* sto) {
     dist[i] = DBL_MAX;
   }
   dist[from] = 0.0;
+  target     = to;
 
-  if(max_dist > 0) {
+  if(max_dist > 0 && from != to) {
     collect(from,dist[from],max_dist); 
   }  
 
-  return dist[to];
+  return dist[to] <= cutoff ? dist[to] : DBL_MAX;
 }
@@ -14,15 +14,15 @@ namespace mico {
 
     /**
      * An implementation of relatedness using depth first partial shortes path computation up to a maximum number of
-     * edges over the knowledge graph.
+     * edges over the knowledge graph. Branches whose partial weight already exceeds the best distance
+     * found to the target (or the cutoff) are not explored further.
      */
     class dfs : public virtual base {
 
       mico::graph::rgraph_weighted* graph;
 
-      int max_dist;
-
       double* dist;   // vector with current distance used by DFS algorithm
+      int     target; // vertice to which the distance is computed
 
       void collect(int node, double pweight, int depth);
 
@@ -45,7 +45,9 @@ namespace mico {
        * shared instance data structures, so calling this method on the same instance in multiple
        * threads is not safe.
        */
-      double relatedness(const char* from, const char* to);
+      double relatedness(int from, int to);
+
+      using base::relatedness;
 
 
     };
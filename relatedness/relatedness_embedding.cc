@@ -0,0 +1,81 @@
+#include <float.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "relatedness_embedding.h"
+
+namespace mico {
+  namespace relatedness {
+
+    int embedding::dot(const int8_t* a, const int8_t* b, int dim) {
+      int i = 0, sum = 0;
+
+#if defined(__AVX2__)
+      __m256i acc = _mm256_setzero_si256();
+      for(; i + 32 <= dim; i += 32) {
+	__m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+	__m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+
+	// sign-extend to 16bit and multiply-add pairs into 32bit lanes
+	acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm256_castsi256_si128(va)),
+						      _mm256_cvtepi8_epi16(_mm256_castsi256_si128(vb))));
+	acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm256_extracti128_si256(va, 1)),
+						      _mm256_cvtepi8_epi16(_mm256_extracti128_si256(vb, 1))));
+      }
+      __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+      s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1,0,3,2)));
+      s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2,3,0,1)));
+      sum = _mm_cvtsi128_si32(s);
+#elif defined(__SSE2__)
+      __m128i acc = _mm_setzero_si128();
+      for(; i + 16 <= dim; i += 16) {
+	__m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+	__m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+
+	// sign-extend to 16bit (SSE2 has no pmovsx) and multiply-add pairs into 32bit lanes
+	acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(va, va), 8),
+						_mm_srai_epi16(_mm_unpacklo_epi8(vb, vb), 8)));
+	acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_srai_epi16(_mm_unpackhi_epi8(va, va), 8),
+						_mm_srai_epi16(_mm_unpackhi_epi8(vb, vb), 8)));
+      }
+      acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1,0,3,2)));
+      acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2,3,0,1)));
+      sum = _mm_cvtsi128_si32(acc);
+#endif
+
+      for(; i < dim; i++) {
+	sum += (int)a[i] * b[i];
+      }
+      return sum;
+    }
+
+
+    float embedding::similarity(const mico::graph::embeddings* e, int from, int to) {
+      if(e == NULL || from < 0 || to < 0 || from >= e->num_vertices || to >= e->num_vertices
+	 || e->norms[from] == 0.0f || e->norms[to] == 0.0f) {
+	return 0.0f;
+      }
+      return dot(e->get(from), e->get(to), e->dim) / (e->norms[from] * e->norms[to]);
+    }
+
+
+    double embedding::relatedness(int from, int to) {
+      const mico::graph::embeddings* e = graph->embedding;
+
+      if(e == NULL || from < 0 || to < 0 || from >= e->num_vertices || to >= e->num_vertices
+	 || e->norms[from] == 0.0f || e->norms[to] == 0.0f) {
+	return DBL_MAX;
+      }
+
+      double c = dot(e->get(from), e->get(to), e->dim) / ((double)e->norms[from] * e->norms[to]);
+
+      if(c <= 0.0) {
+	return DBL_MAX;
+      }
+      return c < 1.0 ? 1.0 - c : 0.0;
+    }
+
+  }
+}
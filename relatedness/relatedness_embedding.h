@@ -0,0 +1,55 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_RELATEDNESS_EMBEDDING
+#define HAVE_RELATEDNESS_EMBEDDING 1
+
+#include "relatedness_base.h"
+#include "../graph/embeddings.h"
+
+namespace mico {
+
+  namespace relatedness {
+
+    /**
+     * An implementation of relatedness using the cosine similarity of the precomputed (random
+     * walk) embeddings of the two resources (see wsd-create -m). All graph traversal happens
+     * offline, so computing the relatedness is a single short dot product over 8bit vectors
+     * (using AVX2 if available).
+     *
+     * The result is in the range [0,1) with smaller values for stronger relations, or DBL_MAX in
+     * case the embeddings are not positively correlated or the graph has no embeddings.
+     */
+    class embedding : public virtual base {
+
+      mico::graph::rgraph* graph;
+
+    public:
+
+      /**
+       * Initialise an embedding comparison over the given graph. The maximum distance is given by
+       * the embeddings and therefore ignored.
+       */
+      embedding(mico::graph::rgraph* graph, int max_dist) : base(graph, max_dist), graph(graph) {};
+
+      /**
+       * Dot product of two quantized vectors of the given dimension.
+       */
+      static int dot(const int8_t* a, const int8_t* b, int dim);
+
+      /**
+       * Cosine similarity of the embeddings of the two vertices; 0 if one of them has id -1 or no
+       * embedding.
+       */
+      static float similarity(const mico::graph::embeddings* e, int from, int to);
+
+      /**
+       * Relatedness computation via cosine similarity of the embeddings of the two nodes.
+       */
+      double relatedness(int from, int to);
+
+      using base::relatedness;
+
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,112 @@
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include "relatedness_neighborhood.h"
+#include "intersect.h"
+
+using namespace mico::graph;
+
+namespace mico {
+  namespace relatedness {
+
+    // functor counting common neighbors
+    struct count_common {
+      long int n;
+
+      count_common() : n(0) {};
+
+      inline void operator()(uint32_t) { n++; };
+    };
+
+    // functor summing the inverse log degree of common neighbors
+    struct adamic_adar_sum {
+      const adjacency* adj;
+      double sum;
+
+      adamic_adar_sum(const adjacency* adj) : adj(adj), sum(0.0) {};
+
+      inline void operator()(uint32_t v) {
+	int d = adj->degree(v);
+	if(d > 1) {
+	  sum += 1.0 / log((double)d);
+	}
+      };
+    };
+
+
+    neighborhood::neighborhood(rgraph* graph, int max_dist, bool weighted)
+      : base(graph, max_dist), graph(graph), adj(graph->get_adjacency()), weighted(weighted) {
+      bits_from = new uint64_t[NEIGHBORHOOD_WORDS];
+      bits_to   = new uint64_t[NEIGHBORHOOD_WORDS];
+    }
+
+
+    neighborhood::~neighborhood() {
+      delete[] bits_from;
+      delete[] bits_to;
+    }
+
+
+    // overlap of the direct neighborhoods, exact
+    double neighborhood::overlap(int from, int to) {
+      int df = adj->degree(from), dt = adj->degree(to);
+
+      if(df == 0 || dt == 0) {
+	return 0.0;
+      }
+
+      if(weighted) {
+	adamic_adar_sum f(adj);
+	intersect(adj->neighbors(from), df, adj->neighbors(to), dt, f);
+
+	// map the unbounded index into [0,1)
+	return f.sum / (1.0 + f.sum);
+      } else {
+	count_common f;
+	intersect(adj->neighbors(from), df, adj->neighbors(to), dt, f);
+
+	return (double)f.n / (double)(df + dt - f.n);
+      }
+    }
+
+
+    // overlap of the 2-hop neighborhoods, estimated using bitmap sketches
+    double neighborhood::overlap_2hop(int from, int to) {
+      int k;
+
+      memset(bits_from, 0, NEIGHBORHOOD_WORDS * sizeof(uint64_t));
+      memset(bits_to,   0, NEIGHBORHOOD_WORDS * sizeof(uint64_t));
+
+      adj->add_neighborhood(from, bits_from);
+      for(k=0; k<adj->degree(from); k++) {
+	adj->add_neighborhood(adj->neighbors(from)[k], bits_from);
+      }
+
+      adj->add_neighborhood(to, bits_to);
+      for(k=0; k<adj->degree(to); k++) {
+	adj->add_neighborhood(adj->neighbors(to)[k], bits_to);
+      }
+
+      long int common = 0, all = 0;
+      for(k=0; k<NEIGHBORHOOD_WORDS; k++) {
+	common += __builtin_popcountll(bits_from[k] & bits_to[k]);
+	all    += __builtin_popcountll(bits_from[k] | bits_to[k]);
+      }
+
+      return all > 0 ? (double)common / (double)all : 0.0;
+    }
+
+
+    double neighborhood::relatedness(int from, int to) {
+      if(from < 0 || to < 0 || from >= adj->num_vertices || to >= adj->num_vertices) {
+	return DBL_MAX;
+      }
+
+      double o = max_dist > 1 ? overlap_2hop(from, to) : overlap(from, to);
+
+      return o > 0.0 ? 1.0 - o : DBL_MAX;
+    }
+
+  }
+}
@@ -0,0 +1,88 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_RELATEDNESS_NEIGHBORHOOD
+#define HAVE_RELATEDNESS_NEIGHBORHOOD 1
+
+#include <stdint.h>
+
+#include "relatedness_base.h"
+#include "../graph/adjacency.h"
+
+namespace mico {
+
+  namespace relatedness {
+
+    /**
+     * An implementation of relatedness using the overlap of the neighborhoods of the two resources
+     * in the knowledge graph (ignoring edge direction). The more neighbors two resources have in
+     * common, the stronger the relation. Depending on the configuration, the overlap is either
+     * measured as Jaccard coefficient or as Adamic-Adar index, which weights each common neighbor
+     * by the inverse logarithm of its degree so that hubs contribute less than specific neighbors.
+     *
+     * With a maximum distance of 1 (or less), the exact direct neighborhoods are intersected. With
+     * a maximum distance of 2 or more, the 2-hop neighborhoods are compared instead using bitmap
+     * sketches (Jaccard estimate in both modes).
+     *
+     * The result is in the range [0,1) with smaller values for stronger relations, or DBL_MAX in
+     * case the two resources have no neighbor in common.
+     */
+    class neighborhood : public virtual base {
+
+      mico::graph::rgraph* graph;
+
+      const mico::graph::adjacency* adj;
+
+      bool weighted;
+
+      // helper structures for the 2-hop variant (not thread safe!)
+      uint64_t* bits_from;
+      uint64_t* bits_to;
+
+      double overlap(int from, int to);
+      double overlap_2hop(int from, int to);
+
+    public:
+
+      /**
+       * Initialise a neighborhood comparison over the given graph. If weighted is true, compute
+       * the Adamic-Adar index instead of the Jaccard coefficient.
+       */
+      neighborhood(mico::graph::rgraph* graph, int max_dist, bool weighted);
+
+      /**
+       * Cleanup helper structures
+       */
+      ~neighborhood();
+
+      /**
+       * Relatedness computation via neighborhood overlap of the two nodes. It uses shared instance
+       * data structures, so calling this method on the same instance in multiple threads is not
+       * safe.
+       */
+      double relatedness(int from, int to);
+
+      using base::relatedness;
+
+    };
+
+
+    /**
+     * Neighborhood relatedness using the Jaccard coefficient of the neighbor sets.
+     */
+    class jaccard : public neighborhood {
+    public:
+      jaccard(mico::graph::rgraph* graph, int max_dist) : base(graph, max_dist), neighborhood(graph, max_dist, false) {};
+    };
+
+
+    /**
+     * Neighborhood relatedness using the Adamic-Adar index of the neighbor sets.
+     */
+    class adamic_adar : public neighborhood {
+    public:
+      adamic_adar(mico::graph::rgraph* graph, int max_dist) : base(graph, max_dist), neighborhood(graph, max_dist, true) {};
+    };
+
+  }
+}
+
+#endif
@@ -11,11 +11,13 @@ using namespace mico::graph;
 using namespace mico::relatedness;
 
 // constructor: initialise helper structures
-mico::relatedness::shortest_path::shortest_path(rgraph_weighted* graph, int max_dist) : graph(graph), max_dist(max_dist) {
+mico::relatedness::shortest_path::shortest_path(rgraph_weighted* graph, int max_dist) : base(graph, max_dist), graph(graph) {
   dist = new double[graph->num_vertices];
   idx =  new int[graph->num_vertices];
 
   pq_init(&queue,graph->num_vertices, dist,idx);
+
+  target.assign(graph->num_vertices, 0);
 }
 
 // destructor: free helper structures
@@ -25,50 +27,79 @@ mico::relatedness::shortest_path::~shortest_path() {
   delete[] idx;
 }
 
-// DFS to look for all vertices up to a certain distance
+// breadth-first search to look for all vertices up to a certain distance
 inline void mico::relatedness::shortest_path::collect(int node, int depth) {
   long int i, j, v;
+  size_t k;
+  int u;
+
+  frontier.assign(1, node);
+  for(; depth > 0 && !frontier.empty(); depth--) {
+    next.clear();
 
+    for(k=0; k<frontier.size(); k++) {
+      u = frontier[k];
 
-  // copied partly from igraph type_indexededgelist.c
-  j=(long int) VECTOR(graph->graph->os)[node+1];
-  for (i=(long int) VECTOR(graph->graph->os)[node]; i<j; i++) {
-    v   = VECTOR(graph->graph->to)[  (long int)VECTOR(graph->graph->oi)[i] ];
+      // copied partly from igraph type_indexededgelist.c
+      j=(long int) VECTOR(graph->graph->os)[u+1];
+      for (i=(long int) VECTOR(graph->graph->os)[u]; i<j; i++) {
+	v   = VECTOR(graph->graph->to)[  (long int)VECTOR(graph->graph->oi)[i] ];
 
-    if(idx[v] == 0) {
-      pq_insert(&queue, v);
-      if(depth > 1) {
-	collect(v, depth-1);
+	if(idx[v] == 0) {
+	  pq_insert(&queue, v);
+	  next.push_back(v);
+	}
       }
-    }
-  }
 
-  j=(long int) VECTOR(graph->graph->is)[node+1];
-  for (i=(long int) VECTOR(graph->graph->is)[node]; i<j; i++) {
-    v   = VECTOR(graph->graph->from)[ (long int)VECTOR(graph->graph->ii)[i] ];
-    
-    if(idx[v] == 0) {
-      pq_insert(&queue, v);
-      if(depth > 1) {
-	collect(v, depth-1);
+      j=(long int) VECTOR(graph->graph->is)[u+1];
+      for (i=(long int) VECTOR(graph->graph->is)[u]; i<j; i++) {
+	v   = VECTOR(graph->graph->from)[ (long int)VECTOR(graph->graph->ii)[i] ];
+
+	if(idx[v] == 0) {
+	  pq_insert(&queue, v);
+	  next.push_back(v);
+	}
       }
     }
+
+    frontier.swap(next);
+  }
+}
+
+double mico::relatedness::shortest_path::relatedness(int from, int to) {
+  if(from < 0 || to < 0 || from >= graph->num_vertices || to >= graph->num_vertices) {
+    return DBL_MAX;
   }
 
+  search(from, &to, 1);
 
+  return dist[to] <= cutoff ? dist[to] : DBL_MAX;
 }
 
-double mico::relatedness::shortest_path::relatedness(const char* sfrom, const char* sto) {
-  long int i, j, u, v, eid;
 
-  double alt;
+void mico::relatedness::shortest_path::relatedness(int from, const int* to, int n, double* result) {
+  int k;
 
-  int from = graph->get_vertice_id(sfrom);
-  int to   = graph->get_vertice_id(sto);
+  if(from < 0 || from >= graph->num_vertices) {
+    for(k=0; k<n; k++) {
+      result[k] = DBL_MAX;
+    }
+    return;
+  }
 
-  if(from == -1 || to == -1 || from >= graph->num_vertices || to >= graph->num_vertices) {
-    return DBL_MAX;
+  search(from, to, n);
+
+  for(k=0; k<n; k++) {
+    result[k] = to[k] >= 0 && to[k] < graph->num_vertices && dist[to[k]] <= cutoff ? dist[to[k]] : DBL_MAX;
   }
+}
+
+
+void mico::relatedness::shortest_path::search(int from, const int* to, int n) {
+  long int i, j, u, v, eid;
+  int k, remaining;
+
+  double alt;
 
   // clear index before starting computation
   bzero(idx, graph->num_vertices * sizeof(int));
@@ -91,13 +122,29 @@ double mico::relatedness::shortest_path::relatedness(const char* sfrom, const ch
   if(max_dist > 0) {
     collect(from,max_dist); 
   }
+
+  // mark the targets (once each, invalid ids are left out)
+  remaining = 0;
+  for(k=0; k<n; k++) {
+    if(to[k] >= 0 && to[k] < graph->num_vertices && !target[to[k]]) {
+      target[to[k]] = 1;
+      remaining++;
+    }
+  }
   
-  while(!pq_empty(&queue)) {
+  while(remaining > 0 && !pq_empty(&queue)) {
     u = pq_first(&queue);
 
-    if(u == to) {
+    // all remaining vertices are further away than the targets or the cutoff
+    if(dist[u] > cutoff) {
       break;
     }
+    if(target[u]) {
+      remaining--;
+      if(remaining == 0) {
+	break;
+      }
+    }
 
     // process outgoing edges and vertices
     j=(long int) VECTOR(graph->graph->os)[u+1];
@@ -106,7 +153,7 @@ double mico::relatedness::shortest_path::relatedness(const char* sfrom, const ch
       v   = VECTOR(graph->graph->to)[(long int)eid];
 
       alt = dist[u] + graph->weights[eid];
-      if(alt < dist[v]) {
+      if(alt < dist[v] && alt <= cutoff) {
 	dist[v] = alt;
 	if(queue.indexes[v] != 0) { // only decrease if the value is actually in the queue
 	  pq_decrease(&queue,v);
@@ -122,7 +169,7 @@ double mico::relatedness::shortest_path::relatedness(const char* sfrom, const ch
       
 
       alt = dist[u] + graph->weights[eid];
-      if(alt < dist[v]) {
+      if(alt < dist[v] && alt <= cutoff) {
 	dist[v] = alt;
 	if(queue.indexes[v] != 0) { // only decrease if the value is actually in the queue
 	  pq_decrease(&queue,v);
@@ -131,5 +178,9 @@ double mico::relatedness::shortest_path::relatedness(const char* sfrom, const ch
     }
   }
 
-  return dist[to];
+  for(k=0; k<n; k++) {
+    if(to[k] >= 0 && to[k] < graph->num_vertices) {
+      target[to[k]] = 0;
+    }
+  }
 }
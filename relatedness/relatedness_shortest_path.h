@@ -2,6 +2,8 @@
 #ifndef HAVE_RELATEDNESS_SHORTESTPATH
 #define HAVE_RELATEDNESS_SHORTESTPATH 1
 
+#include <vector>
+
 #include "relatedness_base.h"
 
 extern "C" {
@@ -14,12 +16,11 @@ namespace mico {
 
     /**
      * An implementation of relatedness using shortest path computation (Dijkstra) up to a maximum number of
-     * edges over the knowledge graph.
+     * edges over the knowledge graph. The search stops once the target or a vertice further away than
+     * the cutoff is reached.
      */
     class shortest_path : public virtual base {
 
-      int max_dist;
-
       mico::graph::rgraph_weighted* graph;
 
       // helper structures (not thread safe!)
@@ -28,9 +29,15 @@ namespace mico {
       double* dist;   // vector with current distance used by Dijkstra algorithm
       int*    idx;    // reverse lookup index pointing from vertice ids to queue positions
 
+      std::vector<int> frontier, next; // breadth-first levels used when collecting the search space
+
+      std::vector<char> target;        // flags of the vertices the current search is looking for
 
       void collect(int node, int depth);
 
+      // run Dijkstra from the source until all n targets have been settled
+      void search(int from, const int* to, int n);
+
     public:
       
       /**
@@ -49,7 +56,15 @@ namespace mico {
        * optimized for the internal igraph data structures. It uses shared instance data structures, so
        * calling this method on the same instance in multiple threads is not safe.
        */
-      double relatedness(const char* from, const char* to);
+      double relatedness(int from, int to);
+
+      /**
+       * Relatedness between from and several targets, computed by a single search that stops once
+       * all targets have been reached. Not thread safe either.
+       */
+      void relatedness(int from, const int* to, int n, double* result);
+
+      using base::relatedness;
 
 
     };
@@ -0,0 +1,61 @@
+#include <float.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "relatedness_sketch.h"
+
+namespace mico {
+  namespace relatedness {
+
+    double sketch::similarity(const uint32_t* a, const uint32_t* b, int size) {
+      int i = 0, common = 0, all = 0;
+
+#ifdef __SSE2__
+      const __m128i empty = _mm_set1_epi32((int)SKETCH_EMPTY);
+
+      for(; i + 4 <= size; i += 4) {
+	__m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+	__m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+
+	__m128i ea = _mm_cmpeq_epi32(va, empty);
+	__m128i eb = _mm_cmpeq_epi32(vb, empty);
+
+	// bins with the same minimum (ignoring bins empty in both sketches)
+	int same = _mm_movemask_ps(_mm_castsi128_ps(_mm_andnot_si128(ea, _mm_cmpeq_epi32(va, vb))));
+	// bins non-empty in at least one of the sketches
+	int used = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(ea, eb))) ^ 0xF;
+
+	common += __builtin_popcount(same);
+	all    += __builtin_popcount(used);
+      }
+#endif
+
+      for(; i < size; i++) {
+	if(a[i] != SKETCH_EMPTY || b[i] != SKETCH_EMPTY) {
+	  all++;
+	  if(a[i] == b[i]) {
+	    common++;
+	  }
+	}
+      }
+
+      return all > 0 ? (double)common / (double)all : 0.0;
+    }
+
+
+    double sketch::relatedness(int from, int to) {
+      const mico::graph::sketches* s = graph->sketch;
+
+      if(s == NULL || from < 0 || to < 0 || from >= s->num_vertices || to >= s->num_vertices) {
+	return DBL_MAX;
+      }
+
+      double j = similarity(s->get(from), s->get(to), s->size);
+
+      return j > 0.0 ? 1.0 - j : DBL_MAX;
+    }
+
+  }
+}
@@ -0,0 +1,51 @@
+// -*- mode: c++; -*-
+#ifndef HAVE_RELATEDNESS_SKETCH
+#define HAVE_RELATEDNESS_SKETCH 1
+
+#include "relatedness_base.h"
+#include "../graph/sketches.h"
+
+namespace mico {
+
+  namespace relatedness {
+
+    /**
+     * An implementation of relatedness using the precomputed neighborhood sketches of the two
+     * resources (see wsd-create -s). The similarity of two sketches estimates the Jaccard
+     * coefficient of the k-hop neighborhoods of the resources; resources with overlapping
+     * neighborhoods are also reachable from each other within 2k edges. Comparing two sketches is a
+     * constant time operation, so this algorithm is a good first stage before expensive exact
+     * algorithms.
+     *
+     * The result is in the range [0,1) with smaller values for stronger relations, or DBL_MAX in
+     * case the sketches do not overlap or the graph has no sketches.
+     */
+    class sketch : public virtual base {
+
+      mico::graph::rgraph* graph;
+
+    public:
+
+      /**
+       * Initialise a sketch comparison over the given graph. The maximum distance is given by
+       * the sketches and therefore ignored.
+       */
+      sketch(mico::graph::rgraph* graph, int max_dist) : base(graph, max_dist), graph(graph) {};
+
+      /**
+       * Estimate the Jaccard coefficient of two sketches of the same size.
+       */
+      static double similarity(const uint32_t* a, const uint32_t* b, int size);
+
+      /**
+       * Relatedness computation via sketch comparison of the two nodes.
+       */
+      double relatedness(int from, int to);
+
+      using base::relatedness;
+
+    };
+  }
+}
+
+#endif
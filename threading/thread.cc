@@ -34,6 +34,7 @@ void mico::threading::thread::start() {
     if(s != 0) {
       errno = s; perror("error creating thread"); exit(1);
     }
+    joinable = true;
   } else {
     throw exception("thread already running or cancelled");
   }
@@ -58,8 +59,11 @@ void mico::threading::thread::reset() {
 
 
 void mico::threading::thread::join() {
-  if(state == RUNNING) {
+  // the thread might already have finished, but still needs to be joined to release its resources
+  // and to make sure it no longer accesses this object
+  if(joinable) {
     pthread_join(_thread, NULL);
+    joinable = false;
   }
 }
 
@@ -18,6 +18,8 @@ namespace mico {
 
       pthread_t _thread;    // thread descriptor 
 
+      bool joinable;        // thread has been started but not yet joined
+
       // internal runner to be called by pthread_create
       static void * runner(void *);
       
@@ -26,7 +28,12 @@ namespace mico {
 
     public:
 
-      thread() : state(CREATED) {};
+      thread() : state(CREATED), joinable(false) {};
+
+      /**
+       * Threads are usually deleted through pointers to their base class.
+       */
+      virtual ~thread() {};
 
       /**
        * Start the execution of the thread